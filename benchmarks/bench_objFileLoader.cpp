@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+
+#include "synthetic_obj.h"
+
+#include <load_obj.h>
+
+namespace {
+
+struct NullCollector : ObjFile::TriangleCollector {
+    void handle_vertex(const ObjFile::Vertex& v, const ObjFile::TextureCoordinates& t,
+                       const ObjFile::VertexNormal& n) override
+    {
+        benchmark::DoNotOptimize(&v);
+        benchmark::DoNotOptimize(&t);
+        benchmark::DoNotOptimize(&n);
+    }
+};
+
+void report_throughput(benchmark::State& state, size_t bytes, size_t faces)
+{
+    if (bytes > 0) {
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+    }
+    state.counters["faces"] = benchmark::Counter(static_cast<double>(faces),
+                                                 benchmark::Counter::kIsIterationInvariantRate);
+}
+
+size_t face_count(const ObjFile& obj)
+{
+    size_t faces = 0;
+    for (const auto& name : obj.objects()) {
+        faces += obj[name].faces.size();
+    }
+    return faces;
+}
+
+void BM_ParseFace(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ObjFile::parse_face("1073/1201/388 1072/1200/388 1074/1202/388"));
+    }
+}
+BENCHMARK(BM_ParseFace);
+
+void BM_ParseVertex(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ObjFile::parse_vertex("-0.833333 1.000000 -0.291667"));
+    }
+}
+BENCHMARK(BM_ParseVertex);
+
+void BM_ProcessAsset(benchmark::State& state, const char* filename)
+{
+    const auto text = read_asset(filename);
+    size_t faces = 0;
+    for (auto _ : state) {
+        ObjFile obj;
+        obj.process_text(text);
+        faces = face_count(obj);
+        benchmark::DoNotOptimize(obj.vertices.data());
+    }
+    report_throughput(state, text.size(), faces);
+}
+BENCHMARK_CAPTURE(BM_ProcessAsset, rc_truck, "rc-truck.obj");
+BENCHMARK_CAPTURE(BM_ProcessAsset, track_segments, "track_segments.obj");
+BENCHMARK_CAPTURE(BM_ProcessAsset, tree, "tree.obj");
+
+void BM_ProcessFile(benchmark::State& state)
+{
+    const auto filename = asset_path("track_segments.obj");
+    const auto bytes = read_asset("track_segments.obj").size();
+    size_t faces = 0;
+    for (auto _ : state) {
+        ObjFile obj;
+        obj.process_file(filename.c_str());
+        faces = face_count(obj);
+    }
+    report_throughput(state, bytes, faces);
+}
+BENCHMARK(BM_ProcessFile);
+
+void BM_ProcessSyntheticText(benchmark::State& state)
+{
+    const auto requested_faces = static_cast<size_t>(state.range(0));
+    const auto& text = cached_grid_obj(requested_faces);
+    for (auto _ : state) {
+        ObjFile obj;
+        obj.process_text(text);
+        benchmark::DoNotOptimize(obj.vertices.data());
+    }
+    report_throughput(state, text.size(), grid_face_count(requested_faces));
+}
+BENCHMARK(BM_ProcessSyntheticText)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ProcessSyntheticTextParallel(benchmark::State& state)
+{
+    const auto requested_faces = static_cast<size_t>(state.range(0));
+    const auto& text = cached_grid_obj(requested_faces);
+    for (auto _ : state) {
+        ObjFile obj;
+        obj.process_text_parallel(text);
+        benchmark::DoNotOptimize(obj.vertices.data());
+    }
+    report_throughput(state, text.size(), grid_face_count(requested_faces));
+}
+BENCHMARK(BM_ProcessSyntheticTextParallel)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 10'000'000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_ProduceTriangleList(benchmark::State& state)
+{
+    const auto requested_faces = static_cast<size_t>(state.range(0));
+    ObjFile obj;
+    obj.process_text(cached_grid_obj(requested_faces));
+    NullCollector collector;
+    for (auto _ : state) {
+        obj.produce_triangle_list("Grid", &collector);
+    }
+    report_throughput(state, 0, grid_face_count(requested_faces));
+}
+BENCHMARK(BM_ProduceTriangleList)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 1'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ProduceIndexedMesh(benchmark::State& state)
+{
+    const auto requested_faces = static_cast<size_t>(state.range(0));
+    ObjFile obj;
+    obj.process_text(cached_grid_obj(requested_faces));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(obj.produce_indexed_mesh("Grid"));
+    }
+    report_throughput(state, 0, grid_face_count(requested_faces));
+}
+BENCHMARK(BM_ProduceIndexedMesh)
+    ->RangeMultiplier(10)
+    ->Range(10'000, 1'000'000)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
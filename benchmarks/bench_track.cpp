@@ -0,0 +1,159 @@
+#include <benchmark/benchmark.h>
+
+#include "synthetic_obj.h"
+
+#include <instancing.h>
+#include <mesh_cache.h>
+#include <model.h>
+#include <track.h>
+#include <track_field.h>
+#include <track_query.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+void BM_LoadTrackSegments(benchmark::State& state)
+{
+    const auto filename = asset_path("track_segments.obj");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(load_models(filename.c_str()));
+    }
+}
+BENCHMARK(BM_LoadTrackSegments);
+
+// The same load through a baked cache, for comparison with the OBJ path above.
+void BM_LoadTrackSegmentsFromCache(benchmark::State& state)
+{
+    const auto filename = asset_path("track_segments.obj");
+    const auto cache_filename =
+        (std::filesystem::temp_directory_path() / "bench_track_segments.meshcache").string();
+    write_mesh_cache(cache_filename.c_str(), 0, load_models(filename.c_str()));
+
+    for (auto _ : state) {
+        const MeshCache cache(cache_filename.c_str(), 0);
+        benchmark::DoNotOptimize(cache["Horizontal"].vertices);
+    }
+    std::remove(cache_filename.c_str());
+}
+BENCHMARK(BM_LoadTrackSegmentsFromCache);
+
+// A square layout of `tiles_per_side` tiles a side with a random segment on every tile
+std::string scrambled_layout(size_t tiles_per_side)
+{
+    std::string layout;
+    std::mt19937 mt(1);
+    for (size_t y = 0; y < tiles_per_side; ++y) {
+        for (size_t x = 0; x < tiles_per_side; ++x) {
+            layout += " s-|r;jl"[mt() % 8];
+        }
+        layout += '\n';
+    }
+    return layout;
+}
+
+// Places every tile of a square track of state.range(0) x state.range(0) tiles and batches them
+// by chunk, as main() does before the first frame. Each segment type stands in for an uploaded
+// mesh with its real bounds.
+void BM_PlaceTrackSegments(benchmark::State& state)
+{
+    const auto segments = load_models(asset_path("track_segments.obj").c_str());
+    std::array<MeshRange, segment_type_count> segment_meshes{};
+    for (size_t type = 1; type < segment_type_count; ++type) {
+        const auto mesh = segments.at(segment_traits[type].mesh_name).view();
+        segment_meshes[type] = {static_cast<int32_t>(mesh.index_count), type, 0, mesh_bounds(mesh)};
+    }
+    const auto tiles_per_side = static_cast<size_t>(state.range(0));
+    const auto track = translate_track_layout(scrambled_layout(tiles_per_side).c_str());
+
+    for (auto _ : state) {
+        WorldGrid grid(track.rows(), track.columns(), 4);
+        std::vector<Placement> placements;
+        place_track_tiles(track, segment_meshes, 10.0f, placements);
+        std::vector<Instance> instances;
+        benchmark::DoNotOptimize(batch_by_chunk(placements, grid, instances));
+        benchmark::DoNotOptimize(instances.data());
+    }
+    state.counters["tiles"] =
+        benchmark::Counter(static_cast<double>(tiles_per_side * tiles_per_side),
+                           benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_PlaceTrackSegments)->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+
+// A scrambled track with 16 points per tile scattered over it the way main() scatters trees
+struct ScatteredPoints {
+    explicit ScatteredPoints(size_t tiles_per_side)
+        : track(translate_track_layout(scrambled_layout(tiles_per_side).c_str())), field(track)
+    {
+        std::mt19937 mt(2);
+        std::uniform_real_distribution<float> position(-30.0f,
+                                                       static_cast<float>(tiles_per_side) * 60.0f);
+        for (size_t i = 0; i < tiles_per_side * tiles_per_side * 16; ++i) {
+            xs.push_back(position(mt));
+            ys.push_back(position(mt));
+        }
+    }
+
+    TrackLayout track;
+    TrackDistanceField field;
+    std::vector<float> xs;
+    std::vector<float> ys;
+};
+
+// Baking the distance field happens once per layout load
+void BM_BakeTrackField(benchmark::State& state)
+{
+    const ScatteredPoints points(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        const TrackDistanceField field(points.track);
+        benchmark::DoNotOptimize(field.distances());
+    }
+}
+BENCHMARK(BM_BakeTrackField)->Arg(20)->Arg(200)->Unit(benchmark::kMillisecond);
+
+void BM_IsOnTrack(benchmark::State& state)
+{
+    const ScatteredPoints points(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> on_track(points.xs.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < points.xs.size(); ++i) {
+            on_track[i] = points.field.is_on_track({points.xs[i], points.ys[i]}, 2.0f);
+        }
+        benchmark::DoNotOptimize(on_track.data());
+    }
+    state.counters["points"] = benchmark::Counter(static_cast<double>(points.xs.size()),
+                                                  benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_IsOnTrack)->Arg(200)->Unit(benchmark::kMicrosecond);
+
+// The same points through TrackQuery, by each path the CPU can run
+void BM_TrackQuery(benchmark::State& state)
+{
+    const ScatteredPoints points(static_cast<size_t>(state.range(0)));
+    const auto path = static_cast<TrackQuery::Path>(state.range(1));
+    if (path == TrackQuery::Path::avx2 && TrackQuery::best_path() != TrackQuery::Path::avx2) {
+        state.SkipWithError("AVX2 is not supported");
+        return;
+    }
+    const TrackQuery query(points.field);
+    std::vector<uint8_t> on_track(points.xs.size());
+    for (auto _ : state) {
+        query.on_track_with(path, points.xs.data(), points.ys.data(), points.xs.size(), 2.0f,
+                            on_track.data());
+        benchmark::DoNotOptimize(on_track.data());
+    }
+    state.counters["points"] = benchmark::Counter(static_cast<double>(points.xs.size()),
+                                                  benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_TrackQuery)
+    ->ArgsProduct({{200}, {0, 1, 2}})
+    ->ArgNames({"tiles", "path"})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <mapped_file.h>
+
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <string>
+
+// Text of a Blender-style OBJ file: one object holding a triangulated grid with at least
+// `face_count` faces, written with the same fixed 6 digit precision Blender uses.
+inline size_t grid_side(size_t face_count)
+{
+    return static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(face_count) / 2)));
+}
+
+inline std::string generate_grid_obj(size_t face_count)
+{
+    const auto side = grid_side(face_count);
+    const auto row = side + 1;
+
+    std::string text;
+    text.reserve(side * side * 2 * 40 + row * row * 60);
+    text += "# Synthetic grid\no Grid\n";
+
+    char line[128];
+    for (size_t y = 0; y < row; ++y) {
+        for (size_t x = 0; x < row; ++x) {
+            const auto u = static_cast<double>(x) / static_cast<double>(side);
+            const auto v = static_cast<double>(y) / static_cast<double>(side);
+            snprintf(line, sizeof(line), "v %f %f %f\nvt %f %f\n", u * 2 - 1,
+                     std::sin(u * 12.0) * 0.1, v * 2 - 1, u, v);
+            text += line;
+        }
+    }
+    text += "vn 0.0000 1.0000 0.0000\n";
+    for (size_t y = 0; y < side; ++y) {
+        for (size_t x = 0; x < side; ++x) {
+            const auto a = y * row + x + 1;
+            const auto b = a + 1;
+            const auto c = a + row;
+            const auto d = c + 1;
+            snprintf(line, sizeof(line), "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", a, a, c, c, b, b);
+            text += line;
+            snprintf(line, sizeof(line), "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", b, b, c, c, d, d);
+            text += line;
+        }
+    }
+    return text;
+}
+
+inline size_t grid_face_count(size_t face_count)
+{
+    const auto side = grid_side(face_count);
+    return side * side * 2;
+}
+
+// Generating the larger grids takes a while, so each size is built once per run.
+inline const std::string& cached_grid_obj(size_t face_count)
+{
+    static std::map<size_t, std::string> cache;
+    auto it = cache.find(face_count);
+    if (it == cache.end()) {
+        it = cache.emplace(face_count, generate_grid_obj(face_count)).first;
+    }
+    return it->second;
+}
+
+inline std::string asset_path(const char* filename)
+{
+    return std::string(RC_ASSET_DIR) + filename;
+}
+
+inline std::string read_asset(const char* filename)
+{
+    const MappedFile file(asset_path(filename).c_str());
+    return std::string(file.text());
+}
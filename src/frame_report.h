@@ -0,0 +1,138 @@
+#pragma once
+
+#include "input_state.h"
+#include "load_obj.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// What was submitted to the GPU while rendering one frame
+struct FrameStats {
+    size_t draw_calls = 0;
+    size_t triangles = 0;
+};
+
+// Driving input for runs without a keyboard. Every line of the script is a frame number followed
+// by the keys held from that frame on: any of W, A, S and D, or `-` for none. Lines starting with
+// `#` are comments.
+//
+//     0 W
+//     90 WA
+//     150 -
+class InputScript {
+  public:
+    explicit InputScript(std::string_view text)
+    {
+        for (const auto& line : ObjFile::split(text, '\n')) {
+            std::string_view rest = line;
+            const auto frame = ObjFile::next_token(rest);
+            if (frame.empty() || frame.front() == '#') {
+                continue;
+            }
+            InputState input;
+            for (const char key : ObjFile::next_token(rest)) {
+                switch (key) {
+                case 'A':
+                case 'a':
+                    input.left = true;
+                    break;
+                case 'D':
+                case 'd':
+                    input.right = true;
+                    break;
+                case 'W':
+                case 'w':
+                    input.accel = true;
+                    break;
+                case 'S':
+                case 's':
+                    input.reverse = true;
+                    break;
+                default:
+                    break;
+                }
+            }
+            _changes.emplace_back(static_cast<size_t>(std::max(ObjFile::parse_int(frame), 0)),
+                                  input);
+        }
+        std::stable_sort(_changes.begin(), _changes.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+
+    // The keys held during `frame`. Nothing is held before the first line of the script.
+    InputState at(size_t frame) const
+    {
+        const auto after = std::upper_bound(
+            _changes.begin(), _changes.end(), frame,
+            [](size_t f, const std::pair<size_t, InputState>& change) { return f < change.first; });
+        return after == _changes.begin() ? InputState{} : std::prev(after)->second;
+    }
+
+  private:
+    std::vector<std::pair<size_t, InputState>> _changes;
+};
+
+// Per-frame timings and submission counts of a benchmark run, summarised by write().
+class FrameReport {
+  public:
+    void add(double cpu_milliseconds, const FrameStats& stats)
+    {
+        _milliseconds.push_back(cpu_milliseconds);
+        _stats.push_back(stats);
+    }
+
+    size_t frame_count() const { return _milliseconds.size(); }
+
+    // The time below which `fraction` of the frames finished, e.g. 0.95 for the 95th percentile
+    double percentile_milliseconds(double fraction) const
+    {
+        if (_milliseconds.empty()) {
+            return 0;
+        }
+        auto sorted = _milliseconds;
+        std::sort(sorted.begin(), sorted.end());
+        const auto last = static_cast<double>(sorted.size() - 1);
+        const auto index = static_cast<size_t>(std::clamp(fraction, 0.0, 1.0) * last + 0.5);
+        return sorted[index];
+    }
+
+    double mean_milliseconds() const
+    {
+        double total = 0;
+        for (const auto ms : _milliseconds) {
+            total += ms;
+        }
+        return _milliseconds.empty() ? 0 : total / static_cast<double>(_milliseconds.size());
+    }
+
+    FrameStats max_stats() const
+    {
+        FrameStats result;
+        for (const auto& stats : _stats) {
+            result.draw_calls = std::max(result.draw_calls, stats.draw_calls);
+            result.triangles = std::max(result.triangles, stats.triangles);
+        }
+        return result;
+    }
+
+    // One `name value` pair per line so runs are easy to diff and to parse in CI.
+    void write(std::ostream& os) const
+    {
+        const auto stats = max_stats();
+        os << "frames " << frame_count() << "\n"
+           << "cpu_ms_mean " << mean_milliseconds() << "\n"
+           << "cpu_ms_median " << percentile_milliseconds(0.5) << "\n"
+           << "cpu_ms_p95 " << percentile_milliseconds(0.95) << "\n"
+           << "cpu_ms_max " << percentile_milliseconds(1.0) << "\n"
+           << "draw_calls_max " << stats.draw_calls << "\n"
+           << "triangles_max " << stats.triangles << "\n";
+    }
+
+  private:
+    std::vector<double> _milliseconds;
+    std::vector<FrameStats> _stats;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "profiler.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+// Measures how long the GPU spends on one render pass each frame with GL_TIME_ELAPSED queries,
+// and records the results on the profiler's GPU track. Results are read back a few frames
+// later, once they are available, so timing never stalls the pipeline. The GPU events are
+// placed at the CPU time their pass was submitted, since elapsed-time queries carry no start
+// time. Queries of the same kind cannot nest, so passes must not overlap.
+class GpuPassTimer {
+  public:
+    GpuPassTimer(Profiler& profiler, const char* name) : _profiler(profiler), _name(name) {}
+
+    ~GpuPassTimer()
+    {
+        for (auto& slot : _slots) {
+            if (slot.query) {
+                glDeleteQueries(1, &slot.query);
+            }
+        }
+    }
+
+    GpuPassTimer(const GpuPassTimer&) = delete;
+    GpuPassTimer& operator=(const GpuPassTimer&) = delete;
+
+    // Starts timing unless profiling is off, or every query is still waiting for its result.
+    void begin()
+    {
+        collect();
+        auto& slot = _slots[_next];
+        if (!_profiler.enabled() || slot.pending) {
+            return;
+        }
+        if (!slot.query) {
+            glGenQueries(1, &slot.query);
+        }
+        slot.submitted_ns = _profiler.now();
+        slot.frame = _profiler.frame();
+        glBeginQuery(GL_TIME_ELAPSED, slot.query);
+        _running = true;
+    }
+
+    void end()
+    {
+        if (!_running) {
+            return;
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        _running = false;
+        _slots[_next].pending = true;
+        _next = (_next + 1) % _slots.size();
+    }
+
+  private:
+    struct Slot {
+        GLuint query = 0;
+        bool pending = false;
+        uint64_t submitted_ns = 0;
+        uint64_t frame = 0;
+    };
+
+    // Records every finished query without waiting on the ones still in flight.
+    void collect()
+    {
+        for (auto& slot : _slots) {
+            if (!slot.pending) {
+                continue;
+            }
+            GLint available = 0;
+            glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                continue;
+            }
+            GLuint64 elapsed_ns = 0;
+            glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed_ns);
+            slot.pending = false;
+            _profiler.record(_name, slot.submitted_ns, elapsed_ns, Profiler::Track::gpu,
+                             slot.frame);
+        }
+    }
+
+    Profiler& _profiler;
+    const char* _name;
+    std::array<Slot, 4> _slots;
+    size_t _next = 0;
+    bool _running = false;
+};
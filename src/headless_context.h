@@ -0,0 +1,139 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#ifdef RC_HAVE_EGL
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <png.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Reads back the bottom-left `width` x `height` pixels of the bound framebuffer and saves them as
+// an RGBA PNG.
+inline bool write_framebuffer_png(const char* filename, int width, int height)
+{
+    const auto row_size = static_cast<size_t>(width) * 4;
+    std::vector<png_byte> pixels(row_size * static_cast<size_t>(height));
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    png_image image;
+    std::memset(&image, 0, sizeof image);
+    image.version = PNG_IMAGE_VERSION;
+    image.width = static_cast<png_uint_32>(width);
+    image.height = static_cast<png_uint_32>(height);
+    image.format = PNG_FORMAT_RGBA;
+
+    // GL rows run bottom to top, and a negative stride tells libpng to flip them
+    const auto row_stride = -static_cast<png_int_32>(row_size);
+    return png_image_write_to_file(&image, filename, 0, pixels.data(), row_stride, NULL) != 0;
+}
+
+#ifdef RC_HAVE_EGL
+
+// An OpenGL 3.3 core context with no window, rendering into an offscreen framebuffer of a fixed
+// size. It is created on EGL's surfaceless platform, so it also runs without a display or GPU,
+// e.g. on Mesa's llvmpipe in CI.
+class HeadlessContext {
+  public:
+    HeadlessContext(int width, int height) : _width(width), _height(height)
+    {
+        const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        _display = get_platform_display ? get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                                               EGL_DEFAULT_DISPLAY, NULL)
+                                        : eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, NULL, NULL)) {
+            fprintf(stderr, "Error: unable to initialise EGL (0x%x)\n", eglGetError());
+            return;
+        }
+        eglBindAPI(EGL_OPENGL_API);
+
+        // Surfaceless contexts render only into framebuffer objects, so they need no config
+        const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                             3,
+                                             EGL_CONTEXT_MINOR_VERSION,
+                                             3,
+                                             EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                             EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                             EGL_NONE};
+        _context =
+            eglCreateContext(_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes);
+        if (_context == EGL_NO_CONTEXT ||
+            !eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, _context)) {
+            fprintf(stderr, "Error: unable to create a surfaceless GL context (0x%x)\n",
+                    eglGetError());
+            return;
+        }
+        gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress));
+
+        glGenRenderbuffers(1, &_color);
+        glBindRenderbuffer(GL_RENDERBUFFER, _color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, _width, _height);
+        glGenRenderbuffers(1, &_depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, _depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _width, _height);
+
+        glGenFramebuffers(1, &_framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depth);
+        _is_valid = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!_is_valid) {
+            fprintf(stderr, "Error: offscreen framebuffer is incomplete\n");
+        }
+    }
+
+    ~HeadlessContext()
+    {
+        if (_framebuffer) {
+            glDeleteFramebuffers(1, &_framebuffer);
+            glDeleteRenderbuffers(1, &_color);
+            glDeleteRenderbuffers(1, &_depth);
+        }
+        if (_context != EGL_NO_CONTEXT) {
+            eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(_display, _context);
+        }
+        if (_display != EGL_NO_DISPLAY) {
+            eglTerminate(_display);
+        }
+    }
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    bool is_valid() const { return _is_valid; }
+
+  private:
+    int _width;
+    int _height;
+    EGLDisplay _display = EGL_NO_DISPLAY;
+    EGLContext _context = EGL_NO_CONTEXT;
+    GLuint _framebuffer = 0;
+    GLuint _color = 0;
+    GLuint _depth = 0;
+    bool _is_valid = false;
+};
+
+#else
+
+// Stand-in for builds made without EGL, which cannot render headless.
+class HeadlessContext {
+  public:
+    HeadlessContext(int /* width */, int /* height */)
+    {
+        fprintf(stderr, "Error: headless rendering needs EGL, which this build was made without\n");
+    }
+
+    bool is_valid() const { return false; }
+};
+
+#endif
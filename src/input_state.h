@@ -0,0 +1,9 @@
+#pragma once
+
+// Which driving keys are held down
+struct InputState {
+    bool left = false;
+    bool right = false;
+    bool accel = false;
+    bool reverse = false;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "track.h"
+#include "world_grid.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Where a Model landed once packed into the shared vertex and index buffers. The counts have
+// the types of GLsizei and GLint, so they go straight to the draw calls.
+struct MeshRange {
+    int32_t index_count;
+    size_t first_index;
+    int32_t base_vertex;
+    Aabb bounds;
+};
+
+// Per-instance data read by vertex.glsl, one entry for every copy of a mesh that is drawn
+struct Instance {
+    glm::vec2 position;
+    float angle;
+    float scale = 1.0f;
+};
+
+// A run of instances in the instance buffer that all draw the same mesh
+struct InstanceBatch {
+    MeshRange mesh;
+    size_t first_instance;
+    size_t instance_count;
+};
+
+// A copy of a static mesh, waiting to be sorted into the chunk it stands in
+struct Placement {
+    MeshRange mesh;
+    Instance instance;
+};
+
+// Places the segment mesh of every tile of `track_layout`. Switching layouts only means
+// re-placing the tiles; the segment meshes themselves never change.
+inline void place_track_tiles(const TrackLayout& track_layout,
+                              const std::array<MeshRange, segment_type_count>& segment_meshes,
+                              const float scale, std::vector<Placement>& placements)
+{
+    for (const auto& tile : track_layout.tiles()) {
+        if (tile.type == SegmentType::grass)
+            continue;
+        const Instance instance{tile.centre, 0, scale};
+        placements.push_back({segment_meshes[static_cast<size_t>(tile.type)], instance});
+    }
+}
+
+// Appends the instances of `placements` to `instances` sorted by chunk and then by mesh, and
+// grows each chunk's bounds to fit them. Returns the batches each chunk draws, one per mesh.
+inline std::vector<std::vector<InstanceBatch>>
+batch_by_chunk(const std::vector<Placement>& placements, WorldGrid& grid,
+               std::vector<Instance>& instances)
+{
+    std::vector<std::pair<size_t, const Placement*>> sorted;
+    sorted.reserve(placements.size());
+    for (const auto& placement : placements) {
+        sorted.push_back({grid.chunk_at(placement.instance.position), &placement});
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.first, a.second->mesh.first_index) <
+               std::tie(b.first, b.second->mesh.first_index);
+    });
+
+    std::vector<std::vector<InstanceBatch>> result(grid.chunk_count());
+    for (const auto& [chunk, placement] : sorted) {
+        const auto& instance = placement->instance;
+        grid.include(chunk,
+                     placed_bounds(placement->mesh.bounds, instance.position, instance.scale));
+
+        auto& batches = result[chunk];
+        if (batches.empty() || batches.back().mesh.first_index != placement->mesh.first_index) {
+            batches.push_back({placement->mesh, instances.size(), 0});
+        }
+        ++batches.back().instance_count;
+        instances.push_back(instance);
+    }
+    return result;
+}
@@ -1,15 +1,28 @@
 #pragma once
 
+#include "mapped_file.h"
+#include "parse_float.h"
+#include "thread_pool.h"
+
 #include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
-#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 struct ObjFile {
     struct LinePartition {
-        std::string command;
-        std::string parameters;
+        std::string_view command;
+        std::string_view parameters;
     };
 
     struct Vertex {
@@ -79,115 +92,429 @@ struct ObjFile {
         bool operator==(const Face& other) const { return indices == other.indices; }
     };
 
+    // Every triangle corner in the file, one index array per attribute. Faces are triangulated as
+    // they are parsed, so triangle i is always corners [3i, 3i + 3) and needs no per-face
+    // offset or count.
+    struct FaceStore {
+        std::vector<int32_t> vertex;
+        std::vector<int32_t> texture;
+        std::vector<int32_t> normal;
+
+        size_t corner_count() const { return vertex.size(); }
+        size_t triangle_count() const { return vertex.size() / 3; }
+
+        Face::Indices corner(size_t i) const { return {vertex[i], texture[i], normal[i]}; }
+
+        void set_corner(size_t i, const Face::Indices& corner)
+        {
+            vertex[i] = corner.vertex;
+            texture[i] = corner.texture;
+            normal[i] = corner.normal;
+        }
+
+        void resize(size_t corner_count)
+        {
+            vertex.resize(corner_count);
+            texture.resize(corner_count);
+            normal.resize(corner_count);
+        }
+
+        void append(FaceStore&& other)
+        {
+            ObjFile::append(vertex, std::move(other.vertex));
+            ObjFile::append(texture, std::move(other.texture));
+            ObjFile::append(normal, std::move(other.normal));
+        }
+    };
+
+    // A contiguous run of triangles in the FaceStore. An object is usually a single range, but
+    // gets one per `o` record if its name is repeated.
+    struct FaceRange {
+        size_t first;
+        size_t count;
+    };
+
+    // Read-only view of one object's triangles.
     struct Object {
-        std::vector<Face> faces;
+        struct Faces {
+            const FaceStore* store;
+            const std::vector<FaceRange>* ranges;
+
+            size_t size() const
+            {
+                size_t count = 0;
+                for (const auto& range : *ranges) {
+                    count += range.count;
+                }
+                return count;
+            }
+
+            Face operator[](size_t i) const
+            {
+                for (const auto& range : *ranges) {
+                    if (i < range.count) {
+                        const auto corner = (range.first + i) * 3;
+                        return {store->corner(corner), store->corner(corner + 1),
+                                store->corner(corner + 2)};
+                    }
+                    i -= range.count;
+                }
+                throw std::out_of_range("face index out of range");
+            }
+
+            // Calls fn(corner_index) for every corner, in file order.
+            template <typename F> void for_each_corner(F&& fn) const
+            {
+                for (const auto& range : *ranges) {
+                    const auto end = (range.first + range.count) * 3;
+                    for (auto corner = range.first * 3; corner < end; ++corner) {
+                        fn(corner);
+                    }
+                }
+            }
+
+            bool operator==(const Faces& other) const
+            {
+                const auto count = size();
+                if (count != other.size()) {
+                    return false;
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    if (!((*this)[i] == other[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        };
+
+        Faces faces;
     };
 
-    static LinePartition partition_line(const std::string& line)
-    {
+    struct IndicesHash {
+        size_t operator()(const Face::Indices& i) const
+        {
+            auto h = static_cast<size_t>(static_cast<uint32_t>(i.vertex));
+            h = h * 0x9E3779B1u ^ static_cast<uint32_t>(i.texture);
+            h = h * 0x9E3779B1u ^ static_cast<uint32_t>(i.normal);
+            return h;
+        }
+    };
+
+    // One unique corner of an indexed mesh.
+    struct MeshVertex {
+        Vertex position;
+        TextureCoordinates tex;
+        VertexNormal normal;
+    };
+
+    template <typename Index> struct IndexedMesh {
+        std::vector<MeshVertex> vertices;
+        std::vector<Index> indices;
+    };
+
+    static constexpr std::string_view whitespace = " \t\r";
 
-        const auto space_index = line.find_first_of(' ');
-        return {line.substr(0, space_index), line.substr(space_index + 1)};
+    static LinePartition partition_line(std::string_view line)
+    {
+        const auto space_index = line.find_first_of(whitespace);
+        if (space_index == std::string_view::npos) {
+            return {line, {}};
+        }
+        return {line.substr(0, space_index), strip_whitespace(line.substr(space_index + 1))};
     }
 
-    static std::string strip_comments(const std::string& line)
+    static std::string_view strip_comments(std::string_view line)
     {
         const auto hash_index = line.find_first_of('#');
         return line.substr(0, hash_index);
     }
 
-    static std::string strip_whitespace(const std::string& s)
+    static std::string_view strip_whitespace(std::string_view s)
     {
-        constexpr auto whitespace = ' ';
         const auto first_non_whitepace = s.find_first_not_of(whitespace);
         const auto last_non_whitespace = s.find_last_not_of(whitespace);
-        if (first_non_whitepace == std::string::npos || last_non_whitespace == std::string::npos) {
-            return "";
+        if (first_non_whitepace == std::string_view::npos ||
+            last_non_whitespace == std::string_view::npos) {
+            return {};
         }
         return s.substr(first_non_whitepace, last_non_whitespace - first_non_whitepace + 1);
     }
 
-    static std::vector<std::string> split(const std::string& s, char delimiter)
+    static std::vector<std::string> split(std::string_view s, char delimiter)
     {
-        std::stringstream ss(s);
-        std::string element;
-
         std::vector<std::string> result;
-        while (std::getline(ss, element, delimiter)) {
-            result.emplace_back(element);
+        while (!s.empty()) {
+            const auto delimiter_index = s.find(delimiter);
+            result.emplace_back(s.substr(0, delimiter_index));
+            if (delimiter_index == std::string_view::npos) {
+                break;
+            }
+            s.remove_prefix(delimiter_index + 1);
         }
         return result;
     }
 
-    static Vertex parse_vertex(const std::string& s)
+    // Pops the next whitespace separated token off the front of `s`. Returns an empty view once
+    // `s` is exhausted.
+    static std::string_view next_token(std::string_view& s)
     {
-        std::stringstream ss(s);
-
-        float x = 0;
-        float y = 0;
-        float z = 0;
-        float w = 1.0f;
+        // A plain character loop; find_first_of searches the whole delimiter set per character.
+        size_t token_start = 0;
+        while (token_start < s.size() && is_whitespace(s[token_start])) {
+            ++token_start;
+        }
+        size_t token_end = token_start;
+        while (token_end < s.size() && !is_whitespace(s[token_end])) {
+            ++token_end;
+        }
+        const auto token = s.substr(token_start, token_end - token_start);
+        s.remove_prefix(token_end);
+        return token;
+    }
 
-        ss >> x;
-        ss >> y;
-        ss >> z;
+    static bool is_whitespace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
 
-        return {x, y, z, w};
+    static int parse_int(std::string_view token)
+    {
+        if (!token.empty() && token.front() == '+') {
+            token.remove_prefix(1);
+        }
+        int value = 0;
+        std::from_chars(token.data(), token.data() + token.size(), value);
+        return value;
     }
 
-    static TextureCoordinates parse_texture_coordinates(const std::string& s)
+    static Vertex parse_vertex(std::string_view s)
     {
-        std::stringstream ss(s);
+        const float x = parse_float(next_token(s));
+        const float y = parse_float(next_token(s));
+        const float z = parse_float(next_token(s));
+        const float w = parse_float(next_token(s), 1.0f);
 
-        float u = 0;
-        float v = 0;
+        return {x, y, z, w};
+    }
 
-        ss >> u;
-        ss >> v;
+    static TextureCoordinates parse_texture_coordinates(std::string_view s)
+    {
+        const float u = parse_float(next_token(s));
+        const float v = parse_float(next_token(s));
 
         return {u, v};
     }
 
-    static VertexNormal parse_vertex_normal(const std::string& s)
+    static VertexNormal parse_vertex_normal(std::string_view s)
     {
-        std::stringstream ss(s);
+        const float x = parse_float(next_token(s));
+        const float y = parse_float(next_token(s));
+        const float z = parse_float(next_token(s));
 
-        float x = 0;
-        float y = 0;
-        float z = 0;
+        return {x, y, z};
+    }
 
-        ss >> x;
-        ss >> y;
-        ss >> z;
+    // Parses a single `v/vt/vn` group. Omitted fields (`v//vn`, `v`) are left as 0, which the
+    // producers read as absent.
+    static Face::Indices parse_face_indices(std::string_view s)
+    {
+        int fields[3] = {0, 0, 0};
+        for (auto& field : fields) {
+            const auto slash_index = s.find('/');
+            field = parse_int(s.substr(0, slash_index));
+            if (slash_index == std::string_view::npos) {
+                break;
+            }
+            s.remove_prefix(slash_index + 1);
+        }
+        return {fields[0], fields[1], fields[2]};
+    }
 
-        return {x, y, z};
+    static void parse_polygon(std::string_view s, std::vector<Face::Indices>& polygon)
+    {
+        polygon.clear();
+        for (auto vertex_text = next_token(s); !vertex_text.empty(); vertex_text = next_token(s)) {
+            polygon.push_back(parse_face_indices(vertex_text));
+        }
     }
 
-    static Face parse_face(const std::string& s)
+    static Face parse_face(std::string_view s)
     {
         Face result;
-        const auto vertex_data = split(s, ' ');
-        for (const auto& vertex_text : vertex_data) {
-            const auto raw_indices = split(vertex_text, '/');
-            std::vector<int> indices;
-            std::transform(raw_indices.begin(), raw_indices.end(), std::back_inserter(indices),
-                           [](const auto& s) { return std::stoi(s); });
-            result.indices.emplace_back(indices);
+        parse_polygon(s, result.indices);
+        return result;
+    }
+
+    // Writes the n - 2 triangles of a polygon as a fan around its first corner.
+    void fan_triangulate(const std::vector<Face::Indices>& polygon, size_t first_corner)
+    {
+        for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+            _faces.set_corner(first_corner++, polygon[0]);
+            _faces.set_corner(first_corner++, polygon[i]);
+            _faces.set_corner(first_corner++, polygon[i + 1]);
         }
+    }
 
-        return result;
+    bool references_known_vertices(const std::vector<Face::Indices>& polygon) const
+    {
+        return std::all_of(polygon.begin(), polygon.end(), [this](const Face::Indices& corner) {
+            return corner.vertex >= 1 && static_cast<size_t>(corner.vertex) <= vertices.size();
+        });
+    }
+
+    // Overwrites the n - 2 triangles starting at `first_corner` with an ear-clipped triangulation
+    // if `polygon` is concave. Convex polygons are left with the fan already written there. All
+    // of the polygon's vertices must already have been parsed.
+    void triangulate_polygon(const std::vector<Face::Indices>& polygon, size_t first_corner)
+    {
+        const auto n = polygon.size();
+
+        // Project onto the axis plane most perpendicular to the polygon's Newell normal.
+        float normal[3] = {0, 0, 0};
+        for (size_t i = 0; i < n; ++i) {
+            const auto& a = vertices[static_cast<size_t>(polygon[i].vertex - 1)];
+            const auto& b = vertices[static_cast<size_t>(polygon[(i + 1) % n].vertex - 1)];
+            normal[0] += (a.y - b.y) * (a.z + b.z);
+            normal[1] += (a.z - b.z) * (a.x + b.x);
+            normal[2] += (a.x - b.x) * (a.y + b.y);
+        }
+        const auto dominant_axis = static_cast<size_t>(
+            std::max_element(normal, normal + 3,
+                             [](float a, float b) { return std::abs(a) < std::abs(b); }) -
+            normal);
+        // Flip one axis as needed so the projected polygon always winds counter-clockwise.
+        const float winding = normal[dominant_axis] < 0 ? -1.0f : 1.0f;
+
+        _projected.clear();
+        for (const auto& corner : polygon) {
+            const auto& v = vertices[static_cast<size_t>(corner.vertex - 1)];
+            switch (dominant_axis) {
+            case 0:
+                _projected.push_back({v.y * winding, v.z});
+                break;
+            case 1:
+                _projected.push_back({v.z * winding, v.x});
+                break;
+            default:
+                _projected.push_back({v.x * winding, v.y});
+                break;
+            }
+        }
+
+        const auto& p = _projected;
+        const auto turn = [&p](size_t a, size_t b, size_t c) {
+            return (p[b].u - p[a].u) * (p[c].v - p[a].v) - (p[b].v - p[a].v) * (p[c].u - p[a].u);
+        };
+
+        bool convex = true;
+        for (size_t i = 0; i < n && convex; ++i) {
+            convex = turn(i, (i + 1) % n, (i + 2) % n) >= 0;
+        }
+        if (convex) {
+            return;
+        }
+
+        _remaining.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            _remaining[i] = i;
+        }
+        const auto emit = [this, &first_corner, &polygon](size_t a, size_t b, size_t c) {
+            _faces.set_corner(first_corner++, polygon[a]);
+            _faces.set_corner(first_corner++, polygon[b]);
+            _faces.set_corner(first_corner++, polygon[c]);
+        };
+
+        while (_remaining.size() > 3) {
+            const auto m = _remaining.size();
+            bool clipped = false;
+            for (size_t k = 0; k < m && !clipped; ++k) {
+                const auto a = _remaining[(k + m - 1) % m];
+                const auto b = _remaining[k];
+                const auto c = _remaining[(k + 1) % m];
+                if (turn(a, b, c) <= 0) {
+                    continue;
+                }
+                // An ear may not contain any of the other remaining corners.
+                const bool is_ear =
+                    std::none_of(_remaining.begin(), _remaining.end(), [&](size_t other) {
+                        return other != a && other != b && other != c && turn(a, b, other) >= 0 &&
+                               turn(b, c, other) >= 0 && turn(c, a, other) >= 0;
+                    });
+                if (is_ear) {
+                    emit(a, b, c);
+                    _remaining.erase(_remaining.begin() + static_cast<std::ptrdiff_t>(k));
+                    clipped = true;
+                }
+            }
+            if (!clipped) {
+                // Self-intersecting or degenerate; fan whatever is left.
+                break;
+            }
+        }
+        for (size_t i = 1; i + 1 < _remaining.size(); ++i) {
+            emit(_remaining[0], _remaining[i], _remaining[i + 1]);
+        }
     }
 
-    const Object& operator[](const std::string& s) const { return _objects.at(s); }
+    // Triangulates `polygon` into the current object. Polygons with fewer than 3 corners are
+    // dropped.
+    void add_polygon(const std::vector<Face::Indices>& polygon)
+    {
+        if (polygon.size() < 3) {
+            return;
+        }
+        if (_current_object_index == no_object) {
+            _current_object_index = object_index(_current_object);
+        }
+        const auto triangle_count = polygon.size() - 2;
+        add_range(_object_ranges[_current_object_index],
+                  {_faces.triangle_count(), triangle_count});
+
+        const auto first_corner = _faces.corner_count();
+        _faces.resize(first_corner + triangle_count * 3);
+        fan_triangulate(polygon, first_corner);
+        if (polygon.size() == 3) {
+            return;
+        }
+
+        if (_defer_polygons) {
+            _pending_polygons.push_back({first_corner, polygon});
+        } else if (references_known_vertices(polygon)) {
+            triangulate_polygon(polygon, first_corner);
+        }
+    }
+
+    // Extends the object's last range when `range` directly follows it.
+    static void add_range(std::vector<FaceRange>& ranges, const FaceRange& range)
+    {
+        if (!ranges.empty() && ranges.back().first + ranges.back().count == range.first) {
+            ranges.back().count += range.count;
+        } else {
+            ranges.push_back(range);
+        }
+    }
+
+    // Looks up an object by name, creating it if this is the first time it has been seen.
+    size_t object_index(const std::string& object_name)
+    {
+        const auto [it, inserted] = _objects.try_emplace(object_name, _object_ranges.size());
+        if (inserted) {
+            _object_ranges.emplace_back();
+        }
+        return it->second;
+    }
+
+    Object operator[](const std::string& s) const
+    {
+        return {{&_faces, &_object_ranges[_objects.at(s)]}};
+    }
 
-    void process_line(const std::string& s)
+    void process_line(std::string_view s)
     {
         const auto line = partition_line(strip_whitespace(strip_comments(s)));
         if (line.command == "o") {
-            const auto object_name = line.parameters;
-            _object_names.push_back(object_name);
-            _current_object = object_name;
-            _objects[_current_object];
+            complete_current_object();
+            _current_object = line.parameters;
+            _object_names.push_back(_current_object);
+            _current_object_index = object_index(_current_object);
         } else if (line.command == "v") {
             vertices.push_back(parse_vertex(line.parameters));
         } else if (line.command == "vt") {
@@ -195,41 +522,325 @@ struct ObjFile {
         } else if (line.command == "vn") {
             vertex_normals.push_back(parse_vertex_normal(line.parameters));
         } else if (line.command == "f") {
-            _objects[_current_object].faces.push_back(parse_face(line.parameters));
+            parse_polygon(line.parameters, _polygon);
+            add_polygon(_polygon);
+        }
+    }
+
+    // Walks `text` once, handing each line to `process_line` as a view into the original buffer.
+    void process_text(std::string_view text)
+    {
+        while (!text.empty()) {
+            const auto newline_index = text.find('\n');
+            process_line(text.substr(0, newline_index));
+            if (newline_index == std::string_view::npos) {
+                break;
+            }
+            text.remove_prefix(newline_index + 1);
+        }
+    }
+
+    // Called with each object's name once its `o` record has been followed by another, or by
+    // finish(). Faces may only reference vertices that come before them, as Blender writes them,
+    // for the object to be complete at that point. Faces before the first `o` record are reported
+    // as the unnamed object "". An object is reported only once, when its first block ends, so
+    // faces from a later `o` record with the same name are added to it without a second call.
+    using ObjectCallback = std::function<void(const ObjFile&, const std::string& object_name)>;
+
+    void on_object_complete(ObjectCallback callback) { _on_object_complete = std::move(callback); }
+
+    // Streaming counterpart of `process_text`: parses every complete line in `chunk` and keeps
+    // the trailing partial line until a later chunk, or finish(), ends it. Chunks may split the
+    // text anywhere, e.g. as they come off disk or out of a decompressor.
+    void feed(std::string_view chunk)
+    {
+        if (!_partial_line.empty()) {
+            const auto newline_index = chunk.find('\n');
+            _partial_line += chunk.substr(0, newline_index);
+            if (newline_index == std::string_view::npos) {
+                return;
+            }
+            process_line(_partial_line);
+            _partial_line.clear();
+            chunk.remove_prefix(newline_index + 1);
+        }
+
+        const auto last_newline = chunk.rfind('\n');
+        if (last_newline == std::string_view::npos) {
+            _partial_line = chunk;
+            return;
+        }
+        process_text(chunk.substr(0, last_newline + 1));
+        _partial_line = chunk.substr(last_newline + 1);
+    }
+
+    // Parses whatever is left over from the last `feed` and completes the last object.
+    void finish()
+    {
+        if (!_partial_line.empty()) {
+            process_line(_partial_line);
+            _partial_line.clear();
         }
+        complete_current_object();
     }
 
-    void process_text(const std::string& text)
+    void complete_current_object()
     {
-        for (const auto& line : split(text, '\n')) {
-            process_line(line);
+        if (!_on_object_complete || (_object_names.empty() && _current_object_index == no_object)) {
+            return;
+        }
+        const auto index = object_index(_current_object);
+        if (index >= _object_reported.size()) {
+            _object_reported.resize(index + 1);
+        }
+        if (!_object_reported[index]) {
+            _object_reported[index] = true;
+            _on_object_complete(*this, _current_object);
         }
     }
 
+    // Splits `text` into roughly equal chunks on line boundaries and parses them concurrently on
+    // `pool`, each into its own ObjFile, then merges the results back in file order. Inputs
+    // smaller than two chunks are parsed serially.
+    void process_text_parallel(std::string_view text, ThreadPool& pool = ThreadPool::shared(),
+                               size_t min_chunk_size = 256 * 1024)
+    {
+        const auto chunk_count =
+            std::min(pool.size(), text.size() / std::max(min_chunk_size, size_t{1}));
+        if (chunk_count < 2) {
+            process_text(text);
+            return;
+        }
+
+        std::vector<std::string_view> chunks;
+        chunks.reserve(chunk_count);
+        while (!text.empty()) {
+            const auto chunks_left = chunk_count - chunks.size();
+            const auto split_index =
+                chunks_left > 1 ? text.find('\n', text.size() / chunks_left) : text.npos;
+            const auto chunk =
+                text.substr(0, split_index == text.npos ? text.npos : split_index + 1);
+            chunks.push_back(chunk);
+            text.remove_prefix(chunk.size());
+        }
+
+        std::vector<ObjFile> parsed(chunks.size());
+        pool.parallel_for(chunks.size(), [&](size_t i) {
+            // Chunks only see their own vertices, so concave polygons get fanned for now and
+            // fixed up once everything has been merged.
+            parsed[i]._current_object = continued_object;
+            parsed[i]._defer_polygons = true;
+            parsed[i].process_text(chunks[i]);
+        });
+
+        for (auto& chunk : parsed) {
+            merge_chunk(std::move(chunk));
+        }
+
+        for (const auto& polygon : _pending_polygons) {
+            if (references_known_vertices(polygon.corners)) {
+                triangulate_polygon(polygon.corners, polygon.first_corner);
+            }
+        }
+        _pending_polygons.clear();
+    }
+
+    // Parses straight out of a read-only mapping of `filename`, so the file is never copied onto
+    // the heap. Pass a pool to parse it in parallel chunks. Returns false if the file could not
+    // be opened.
+    bool process_file(const char* filename, ThreadPool* pool = nullptr)
+    {
+        const MappedFile file(filename);
+        if (!file.is_open()) {
+            return false;
+        }
+        if (pool) {
+            process_text_parallel(file.text(), *pool);
+        } else {
+            process_text(file.text());
+        }
+        return true;
+    }
+
     int object_count() const { return static_cast<int>(_object_names.size()); }
     const std::vector<std::string>& objects() const { return _object_names; }
 
     void produce_triangle_list(const std::string& object_name, TriangleCollector* collector)
     {
-        const Object& obj = _objects.at(object_name);
-        for (const auto& face : obj.faces) {
-            // grab only the first 3 vertices of each face. If output was not trianglated, we will
-            // have some "holes", but at least our output will be useable.
-            for (size_t i = 0; i < 3; ++i) {
-                const auto v_index = static_cast<size_t>(face.indices[i].vertex - 1);
-                const auto t_index = static_cast<size_t>(face.indices[i].texture - 1);
-                const auto n_index = static_cast<size_t>(face.indices[i].normal - 1);
-                collector->handle_vertex(vertices[v_index], tex_coords[t_index],
-                                         vertex_normals[n_index]);
+        (*this)[object_name].faces.for_each_corner([&](size_t corner) {
+            const auto v_index = static_cast<size_t>(_faces.vertex[corner] - 1);
+            collector->handle_vertex(vertices[v_index], corner_tex_coords(corner),
+                                     corner_normal(corner));
+        });
+    }
+
+    // Like produce_triangle_list, but corners sharing the same vertex/texture/normal indices are
+    // emitted once and referenced from the index array. Throws std::overflow_error if the object
+    // has more unique corners than `Index` can address.
+    template <typename Index = uint32_t>
+    IndexedMesh<Index> produce_indexed_mesh(const std::string& object_name) const
+    {
+        const auto faces = (*this)[object_name].faces;
+        const auto corner_count = faces.size() * 3;
+
+        IndexedMesh<Index> result;
+        result.indices.reserve(corner_count);
+        std::unordered_map<Face::Indices, Index, IndicesHash> unique_corners;
+        unique_corners.reserve(corner_count);
+
+        faces.for_each_corner([&](size_t corner_index) {
+            auto corner = _faces.corner(corner_index);
+            if (!has_normal(corner.normal)) {
+                // Each triangle has its own face normal, so its corners are never shared
+                corner.normal = -static_cast<int>(corner_index / 3) - 1;
             }
+            const auto next_index = result.vertices.size();
+            const auto [it, inserted] =
+                unique_corners.try_emplace(corner, static_cast<Index>(next_index));
+            if (inserted) {
+                if (next_index > std::numeric_limits<Index>::max()) {
+                    throw std::overflow_error(object_name +
+                                              " has too many vertices for its index type");
+                }
+                result.vertices.push_back({vertices[static_cast<size_t>(corner.vertex - 1)],
+                                           corner_tex_coords(corner_index),
+                                           corner_normal(corner_index)});
+            }
+            result.indices.push_back(it->second);
+        });
+        return result;
+    }
+
+    // Texture coordinates and normals are optional in faces (`v//vn`, `v`), where their index is
+    // left as 0. A missing texture coordinate reads as (0, 0) and a missing normal as the normal
+    // of the corner's triangle. Indices past the end of the file's lists count as missing too.
+    bool has_normal(int index) const
+    {
+        return index >= 1 && static_cast<size_t>(index) <= vertex_normals.size();
+    }
+
+    TextureCoordinates corner_tex_coords(size_t corner) const
+    {
+        const auto index = _faces.texture[corner];
+        return index >= 1 && static_cast<size_t>(index) <= tex_coords.size()
+                   ? tex_coords[static_cast<size_t>(index - 1)]
+                   : TextureCoordinates{0, 0};
+    }
+
+    VertexNormal corner_normal(size_t corner) const
+    {
+        const auto index = _faces.normal[corner];
+        if (has_normal(index)) {
+            return vertex_normals[static_cast<size_t>(index - 1)];
         }
+        const auto first = corner - corner % 3;
+        const auto& a = vertices[static_cast<size_t>(_faces.vertex[first] - 1)];
+        const auto& b = vertices[static_cast<size_t>(_faces.vertex[first + 1] - 1)];
+        const auto& c = vertices[static_cast<size_t>(_faces.vertex[first + 2] - 1)];
+        const float ab[3] = {b.x - a.x, b.y - a.y, b.z - a.z};
+        const float ac[3] = {c.x - a.x, c.y - a.y, c.z - a.z};
+        const float normal[3] = {ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2],
+                                 ab[0] * ac[1] - ab[1] * ac[0]};
+        const auto length =
+            std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length <= 0) {
+            return {0, 1, 0};
+        }
+        return {normal[0] / length, normal[1] / length, normal[2] / length};
     }
 
+    // Name chunk workers file faces under until they see their first `o` record. Lines never
+    // contain '\n', so it cannot collide with a real object name.
+    static constexpr std::string_view continued_object = "\n";
+
+    template <typename T> static void append(std::vector<T>& dest, std::vector<T>&& src)
+    {
+        if (dest.empty()) {
+            dest = std::move(src);
+        } else {
+            dest.insert(dest.end(), std::make_move_iterator(src.begin()),
+                        std::make_move_iterator(src.end()));
+        }
+        src.clear();
+    }
+
+    // Face indices are absolute positions within the file, so they stay valid as long as chunks
+    // are merged in file order.
+    void merge_chunk(ObjFile&& chunk)
+    {
+        append(vertices, std::move(chunk.vertices));
+        append(tex_coords, std::move(chunk.tex_coords));
+        append(vertex_normals, std::move(chunk.vertex_normals));
+
+        const auto first_corner = _faces.corner_count();
+        const auto first_triangle = _faces.triangle_count();
+        _faces.append(std::move(chunk._faces));
+
+        // Rebase every range of the chunk onto the merged store and hand it to the matching
+        // object here, in file order.
+        std::vector<std::pair<size_t, FaceRange>> ranges;
+        for (const auto& [object_name, chunk_index] : chunk._objects) {
+            const auto index = object_name == continued_object ? object_index(_current_object)
+                                                               : object_index(object_name);
+            for (const auto& range : chunk._object_ranges[chunk_index]) {
+                ranges.push_back({index, {range.first + first_triangle, range.count}});
+            }
+        }
+        std::sort(ranges.begin(), ranges.end(),
+                  [](const auto& a, const auto& b) { return a.second.first < b.second.first; });
+        for (const auto& [index, range] : ranges) {
+            add_range(_object_ranges[index], range);
+        }
+
+        _object_names.insert(_object_names.end(), chunk._object_names.begin(),
+                             chunk._object_names.end());
+        if (!chunk._object_names.empty()) {
+            _current_object = std::move(chunk._current_object);
+            _current_object_index = no_object;
+        }
+
+        for (auto& polygon : chunk._pending_polygons) {
+            polygon.first_corner += first_corner;
+            _pending_polygons.push_back(std::move(polygon));
+        }
+    }
+
+    // A polygon that was fanned at parse time but may still need ear clipping.
+    struct PendingPolygon {
+        size_t first_corner;
+        std::vector<Face::Indices> corners;
+    };
+
+    struct ProjectedPoint {
+        float u, v;
+    };
+
+    static constexpr size_t no_object = std::numeric_limits<size_t>::max();
+
     std::vector<std::string> _object_names;
-    std::map<std::string, Object> _objects;
+    std::map<std::string, size_t> _objects;
+    std::vector<std::vector<FaceRange>> _object_ranges;
     std::string _current_object;
+    // Resolved from `_current_object` on its first face, so stray faces before any `o` record
+    // still create the unnamed object on demand.
+    size_t _current_object_index = no_object;
+
+    FaceStore _faces;
 
     std::vector<Vertex> vertices;
     std::vector<TextureCoordinates> tex_coords;
     std::vector<VertexNormal> vertex_normals;
+
+    bool _defer_polygons = false;
+    std::vector<PendingPolygon> _pending_polygons;
+
+    std::string _partial_line;
+    ObjectCallback _on_object_complete;
+    // Indexed like `_object_ranges`, so a name repeated by a later `o` record is reported once
+    std::vector<bool> _object_reported;
+
+    // Scratch space reused across faces so parsing does not allocate per polygon.
+    std::vector<Face::Indices> _polygon;
+    std::vector<ProjectedPoint> _projected;
+    std::vector<size_t> _remaining;
 };
\ No newline at end of file
@@ -1,5 +1,22 @@
 #define _USE_MATH_DEFINES
+#include "frame_report.h"
+#include "gpu_timer.h"
+#include "headless_context.h"
+#include "instancing.h"
 #include "load_obj.h"
+#include "mesh_cache.h"
+#include "model.h"
+#include "profiler.h"
+#include "shader_program.h"
+#include "simplify.h"
+#include "text_file.h"
+#include "texture.h"
+#include "track.h"
+#include "track_field.h"
+#include "track_query.h"
+#include "truck_sim.h"
+#include "vehicle_store.h"
+#include "world_grid.h"
 
 #include <glad/glad.h>
 #define GLFW_INCLUDE_NONE
@@ -9,45 +26,127 @@
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
 
-#include <png.h>
-
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <fstream>
 #include <iostream>
-#include <map>
+#include <optional>
 #include <random>
 #include <string>
+#include <tuple>
+#include <utility>
 
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-struct Vertex {
-    glm::vec4 pos;
-    glm::vec2 tex;
-    glm::vec3 norm;
-};
-
-struct Entity {
+// A tree or anything else that is placed once and never moves
+struct Prop {
     glm::vec2 position;
     float angle = 0;
 };
 
-struct TrackSegmentCoordinate {
-    std::string track_segment;
-    glm::vec4 offset;
+// Where the program reads the Instance fields from
+struct InstanceAttributes {
+    GLuint position;
+    GLuint angle;
+    GLuint scale;
 };
 
+// Command line options. Without --headless the game opens a window and is driven by the keyboard.
+struct Options {
+    bool headless = false;
+    size_t frames = 600;
+    int width = 640;
+    int height = 480;
+    std::string input_filename;
+    std::string report_filename = "frame_report.txt";
+    std::string dump_prefix = "frame_";
+    std::vector<size_t> dump_frames;
+    std::string profile_filename;
+    size_t ai_trucks = 0;
+};
+
+// Used by headless runs that are not given an --input script: accelerate, then weave a little.
+static const char* default_input_script = "0 W\n"
+                                          "120 WA\n"
+                                          "150 W\n"
+                                          "240 WD\n"
+                                          "270 W\n";
+
 bool holding_left = false;
 bool holding_right = false;
 bool holding_accel = false;
 bool holding_reverse = false;
+bool dump_profile_requested = false;
 
-static std::string load_text_from(const char* filename)
+static void print_usage(const char* program)
 {
-    std::ifstream t(filename);
-    std::string str((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
-    return str;
+    fprintf(stderr,
+            "Usage: %s [--headless] [--frames N] [--size WIDTHxHEIGHT] [--input SCRIPT]\n"
+            "          [--report FILE] [--dump FRAME]... [--dump-prefix PREFIX]\n"
+            "          [--profile FILE] [--ai N]\n"
+            "\n"
+            "  --headless     render offscreen without vsync, driven by an input script, and\n"
+            "                 write a frame time report\n"
+            "  --frames N     number of frames to render headless (default 600)\n"
+            "  --size WxH     headless framebuffer size (default 640x480)\n"
+            "  --input FILE   input script, see InputScript in frame_report.h\n"
+            "  --report FILE  where to write the report (default frame_report.txt)\n"
+            "  --dump FRAME   save that frame as PREFIX<FRAME>.png, may be repeated\n"
+            "  --dump-prefix  file name prefix for dumped frames (default frame_)\n"
+            "  --profile FILE record CPU and GPU timings of recent frames and save them to FILE\n"
+            "                 as a Chrome trace on exit, or whenever F12 is pressed\n"
+            "  --ai N         race against N computer driven trucks (default 0)\n",
+            program);
+}
+
+static Options parse_options(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && has_value) {
+            options.frames = static_cast<size_t>(std::max(ObjFile::parse_int(argv[++i]), 0));
+        } else if (arg == "--size" && has_value) {
+            const auto size = ObjFile::split(argv[++i], 'x');
+            if (size.size() == 2) {
+                options.width = std::max(ObjFile::parse_int(size[0]), 1);
+                options.height = std::max(ObjFile::parse_int(size[1]), 1);
+            }
+        } else if (arg == "--input" && has_value) {
+            options.input_filename = argv[++i];
+        } else if (arg == "--report" && has_value) {
+            options.report_filename = argv[++i];
+        } else if (arg == "--dump" && has_value) {
+            options.dump_frames.push_back(
+                static_cast<size_t>(std::max(ObjFile::parse_int(argv[++i]), 0)));
+        } else if (arg == "--dump-prefix" && has_value) {
+            options.dump_prefix = argv[++i];
+        } else if (arg == "--profile" && has_value) {
+            options.profile_filename = argv[++i];
+        } else if (arg == "--ai" && has_value) {
+            options.ai_trucks = static_cast<size_t>(std::max(ObjFile::parse_int(argv[++i]), 0));
+        } else {
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    return options;
+}
+
+static void write_profile(const Profiler& profiler, const std::string& filename)
+{
+    if (profiler.write_chrome_trace(filename.c_str())) {
+        printf("Wrote profile of the last %zu events to %s\n", profiler.size(), filename.c_str());
+    } else {
+        fprintf(stderr, "Error: unable to write %s\n", filename.c_str());
+    }
 }
 
 static void error_callback(int /*error*/, const char* description)
@@ -78,6 +177,8 @@ static void key_callback(GLFWwindow* window, int key, int /* scancode */, int ac
         } else if (action == GLFW_RELEASE) {
             holding_accel = false;
         }
+    } else if (key == GLFW_KEY_F12 && action == GLFW_PRESS) {
+        dump_profile_requested = true;
     } else if (key == GLFW_KEY_S) {
         if (action == GLFW_PRESS) {
             holding_reverse = true;
@@ -87,314 +188,87 @@ static void key_callback(GLFWwindow* window, int key, int /* scancode */, int ac
     }
 }
 
-struct Collector : ObjFile::TriangleCollector {
-    std::vector<Vertex> vertices;
-
-    void handle_vertex(const ObjFile::Vertex& v, const ObjFile::TextureCoordinates& t,
-                       const ObjFile::VertexNormal& n) override
-    {
-        vertices.push_back({{v.x, v.y, v.z, v.w}, {t.u, 1.0f - t.v}, {n.x, n.y, n.z}});
-    }
-};
-
-static std::vector<Vertex> load_model(const char* filename, const char* obj_name)
-{
-    ObjFile obj;
-    obj.process_text(load_text_from(filename));
-
-    Collector collector;
-    obj.produce_triangle_list(obj_name, &collector);
-
-    return collector.vertices;
-}
-
-glm::mat4 model_matrix_from_entity(const Entity& entity)
-{
-    glm::mat4 model{1.0f};
-    model = glm::translate(model, glm::vec3(entity.position.x, 0, entity.position.y));
-    model = glm::rotate(model, entity.angle, glm::vec3(0, 1.0f, 0));
-    return model;
-}
-
-std::map<std::string, std::vector<Vertex>> load_track_segments(const char* filename)
-{
-    ObjFile obj;
-    obj.process_text(load_text_from(filename));
-
-    std::map<std::string, std::vector<Vertex>> result;
-    for (const auto& obj_name : obj.objects()) {
-        Collector collector;
-        obj.produce_triangle_list(obj_name, &collector);
-        result[obj_name] = collector.vertices;
-    }
-    return result;
-}
-
-const char* translate_track_ascii(char c)
-{
-    switch (c) {
-    case 's':
-        return "Starting_Line";
-    case '-':
-        return "Horizontal";
-    case ';':
-        return "Top_Right";
-    case '|':
-        return "Vertical";
-    case 'j':
-        return "Bottom_Right";
-    case 'l':
-        return "Bottom_Left";
-    case 'r':
-        return "Top_Left";
-    default:
-        return "\0";
-    }
-}
-
-std::vector<std::vector<TrackSegmentCoordinate>> translate_track_layout(const char* track_layout)
-{
-
-    const auto layout_rows = ObjFile::split(track_layout, '\n');
-    const auto column_count = layout_rows[0].length();
-
-    std::vector<std::vector<TrackSegmentCoordinate>> result(
-        layout_rows.size(), std::vector<TrackSegmentCoordinate>(column_count));
-
-    constexpr auto tile_size = 60.0f;
-    size_t y = 0;
-    for (const auto& row_text : layout_rows) {
-        size_t x = 0;
-        for (const char c : row_text) {
-            const char* key = translate_track_ascii(c);
-            result[y][x] = {key, {x * tile_size, 0, y * tile_size, 0.0f}};
-            ++x;
-        }
-        ++y;
-    }
-    return result;
-}
-
-// Return a list of coordinates within the track_layout defining the path
-// through the track.
-std::vector<std::pair<size_t, size_t>>
-segment_order(const std::vector<std::vector<TrackSegmentCoordinate>>& track_layout)
+// Packs `meshes` into the currently bound array and element buffers, copying straight from
+// wherever they live (usually a mapped mesh cache). Returns the ranges to draw them with.
+static std::vector<MeshRange> upload_meshes(const std::vector<ModelView>& meshes)
 {
-    struct Offset {
-        enum class Direction : size_t { up, right, down, left };
-        int dRow;
-        int dCol;
-    };
-    size_t startingRow = 0;
-    size_t startingCol = 0;
-
-    // Find "Starting_Line" Extract function for this
-    // Also gotta make sure there's only ONE starting line.
-    for (; startingRow < track_layout.size(); ++startingRow) {
-        bool found = false;
-        for (startingCol = 0; startingCol < track_layout[startingRow].size(); ++startingCol) {
-            const auto& segment = track_layout[startingRow][startingCol];
-            if (segment.track_segment == "Starting_Line") {
-                found = true;
-                break;
-            }
-        }
-        if (found)
-            break;
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    for (const auto& mesh : meshes) {
+        vertex_count += mesh.vertex_count;
+        index_count += mesh.index_count;
     }
-
-    static Offset offsets[] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
-    Offset::Direction current_direction = Offset::Direction::left;
-    std::vector<std::pair<size_t, size_t>> result{{startingRow, startingCol}};
-
-    int row = static_cast<int>(startingRow) + offsets[static_cast<size_t>(current_direction)].dRow;
-    int col = static_cast<int>(startingCol) + offsets[static_cast<size_t>(current_direction)].dCol;
-    while (!(row == static_cast<int>(startingRow) && col == static_cast<int>(startingCol))) {
-        result.push_back({row, col});
-        const auto& segment = track_layout[static_cast<size_t>(row)][static_cast<size_t>(col)];
-        // Turn on curves
-        if (segment.track_segment == "Top_Left") {
-            if (current_direction == Offset::Direction::up) {
-                current_direction = Offset::Direction::right;
-            } else if (current_direction == Offset::Direction::left) {
-                current_direction = Offset::Direction::down;
-            }
-        } else if (segment.track_segment == "Top_Right") {
-            if (current_direction == Offset::Direction::right) {
-                current_direction = Offset::Direction::down;
-            } else if (current_direction == Offset::Direction::up) {
-                current_direction = Offset::Direction::left;
-            }
-        } else if (segment.track_segment == "Bottom_Right") {
-            if (current_direction == Offset::Direction::down) {
-                current_direction = Offset::Direction::left;
-            } else if (current_direction == Offset::Direction::right) {
-                current_direction = Offset::Direction::up;
-            }
-        } else if (segment.track_segment == "Bottom_Left") {
-            if (current_direction == Offset::Direction::left) {
-                current_direction = Offset::Direction::up;
-            } else if (current_direction == Offset::Direction::down) {
-                current_direction = Offset::Direction::right;
-            }
-        }
-        row += offsets[static_cast<size_t>(current_direction)].dRow;
-        col += offsets[static_cast<size_t>(current_direction)].dCol;
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(Vertex) * vertex_count), NULL,
+                 GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(uint32_t) * index_count),
+                 NULL, GL_STATIC_DRAW);
+
+    std::vector<MeshRange> ranges;
+    size_t first_vertex = 0;
+    size_t first_index = 0;
+    for (const auto& mesh : meshes) {
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(sizeof(Vertex) * first_vertex),
+                        static_cast<GLsizeiptr>(sizeof(Vertex) * mesh.vertex_count),
+                        mesh.vertices);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+                        static_cast<GLintptr>(sizeof(uint32_t) * first_index),
+                        static_cast<GLsizeiptr>(sizeof(uint32_t) * mesh.index_count),
+                        mesh.indices);
+        ranges.push_back({static_cast<GLsizei>(mesh.index_count), first_index,
+                          static_cast<GLint>(first_vertex), mesh_bounds(mesh)});
+        first_vertex += mesh.vertex_count;
+        first_index += mesh.index_count;
     }
-
-    return result;
+    return ranges;
 }
 
-glm::vec2 locate_start_position(const char* track_layout)
+// Draws `instance_count` copies of `mesh` in one call, placed by the instances starting at
+// `first_instance` in the buffer bound to GL_ARRAY_BUFFER. GL 3.3 has no base instance, so the
+// batch is selected by moving the instance attribute offsets instead.
+static void draw_mesh_instanced(const MeshRange& mesh, const InstanceAttributes& attributes,
+                                size_t first_instance, size_t instance_count, FrameStats& stats)
 {
-    glm::vec2 result{0};
-    constexpr auto tile_size = 60.0f;
-    float y_offset = 0;
-    for (const auto& row_text : ObjFile::split(track_layout, '\n')) {
-        float x_offset = 0;
-        for (const char c : row_text) {
-            if (c == 's') {
-                result = glm::vec2{x_offset, y_offset};
-                return result;
-            }
-            x_offset += tile_size;
-        }
-        y_offset += tile_size;
-    }
-    return result;
+    ++stats.draw_calls;
+    stats.triangles += static_cast<size_t>(mesh.index_count) / 3 * instance_count;
+
+    const auto base = first_instance * sizeof(Instance);
+    glVertexAttribPointer(attributes.position, 2, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                          reinterpret_cast<void*>(base + offsetof(Instance, position)));
+    glVertexAttribPointer(attributes.angle, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                          reinterpret_cast<void*>(base + offsetof(Instance, angle)));
+    glVertexAttribPointer(attributes.scale, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                          reinterpret_cast<void*>(base + offsetof(Instance, scale)));
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.index_count, GL_UNSIGNED_INT,
+                                      reinterpret_cast<void*>(mesh.first_index * sizeof(uint32_t)),
+                                      static_cast<GLsizei>(instance_count), mesh.base_vertex);
 }
 
-std::pair<size_t, size_t>
-get_segment_coordinate(const glm::vec2& point,
-                       const std::vector<std::vector<TrackSegmentCoordinate>>& track_offsets)
+static void draw_batch(const InstanceBatch& batch, const InstanceAttributes& attributes,
+                       FrameStats& stats)
 {
-    int x = static_cast<int>(point.x + 30) / 60;
-    int y = static_cast<int>(point.y + 30) / 60;
-
-    if (x < 0 || x < 0 || static_cast<size_t>(y) >= track_offsets.size() ||
-        static_cast<size_t>(x) >= track_offsets[0].size())
-        return {std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max()};
-
-    return {static_cast<size_t>(y), static_cast<size_t>(x)};
+    draw_mesh_instanced(batch.mesh, attributes, batch.first_instance, batch.instance_count, stats);
 }
 
-void place_track_segment_with_offset_and_scale(const std::vector<Vertex>& src,
-                                               const glm::vec4& offset, const float scale,
-                                               std::vector<Vertex>& dest)
+// The level of detail `instance` of a mesh with bounds `local` needs, from how tall its bounding
+// sphere appears on screen. `pixels_per_unit` is the height in pixels of one world unit at a view
+// depth of one. `current_level` is the level it was drawn at before, to hold on to near a
+// threshold, or lod_level_count if it has not been drawn yet.
+static size_t lod_level_at(const glm::mat4& view_projection, float pixels_per_unit,
+                           const Aabb& local, const Instance& instance, size_t current_level)
 {
-    for (auto vertex : src) {
-        vertex.pos.x *= scale;
-        vertex.pos.y *= scale;
-        vertex.pos.z *= scale;
-        vertex.pos += offset;
-        dest.emplace_back(vertex);
-    }
-}
-
-GLuint try_png(const char* filename)
-{
-    png_image image;
-
-    /* Only the image structure version number needs to be set. */
-    std::memset(&image, 0, sizeof image);
-    image.version = PNG_IMAGE_VERSION;
-
-    if (png_image_begin_read_from_file(&image, filename)) {
-        image.format = PNG_FORMAT_RGBA;
-        auto buffer = reinterpret_cast<png_bytep>(malloc(PNG_IMAGE_SIZE(image)));
-
-        if (png_image_finish_read(&image, NULL /*background*/, buffer, 0 /*row_stride*/,
-                                  NULL /*colormap for PNG_FORMAT_FLAG_COLORMAP */)) {
-            GLuint texture = 0;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-            auto ptr = reinterpret_cast<GLubyte*>(buffer);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(image.width),
-                         static_cast<GLsizei>(image.height), 0, GL_RGBA, GL_UNSIGNED_BYTE, ptr);
-            return texture;
-        }
-    }
-    return 0;
-}
-
-struct TruckState {
-    glm::vec2 velocity{0};
-    float friction = 2.4f;
-    float max_power = 126.0f;
-    float power = 0;
-    float acceleration = 0.3f;
-};
-
-bool is_on_curve(const glm::vec2& point, const int track_width, const glm::vec2& reference_point)
-{
-    const auto half_track_width = track_width / 2.0f;
-    const auto corner_to_entity = point - reference_point;
-    const auto distance_to_reference = glm::length(corner_to_entity);
-
-    return distance_to_reference >= (30.0f - half_track_width) &&
-           distance_to_reference <= (30.0f + half_track_width);
-}
-
-bool is_on_track(const glm::vec2& point, const int track_width,
-                 const std::vector<std::vector<TrackSegmentCoordinate>>& track_offsets)
-{
-
-    const auto segment_coordinates = get_segment_coordinate(point, track_offsets);
-    const auto& segment = track_offsets[segment_coordinates.first][segment_coordinates.second];
-    const auto half_track_width = track_width / 2;
-
-    if (segment.track_segment.empty()) {
-        return false;
-    }
-
-    if (segment.track_segment == "Vertical") {
-        return point.x >= (segment.offset.x - half_track_width) &&
-               point.x <= (segment.offset.x + half_track_width);
-    }
-
-    if (segment.track_segment == "Horizontal" || segment.track_segment == "Starting_Line") {
-        return point.y >= (segment.offset.z - half_track_width) &&
-               point.y <= (segment.offset.z + half_track_width);
-    }
-    if (segment.track_segment == "Top_Left") {
-        return is_on_curve(point, track_width,
-                           {segment.offset.x + 30.0f, segment.offset.z + 30.0f});
-    }
-    if (segment.track_segment == "Top_Right") {
-        return is_on_curve(point, track_width,
-                           {segment.offset.x - 30.0f, segment.offset.z + 30.0f});
-    }
-    if (segment.track_segment == "Bottom_Right") {
-        return is_on_curve(point, track_width,
-                           {segment.offset.x - 30.0f, segment.offset.z - 30.0f});
-    }
-    if (segment.track_segment == "Bottom_Left") {
-        return is_on_curve(point, track_width,
-                           {segment.offset.x + 30.0f, segment.offset.z - 30.0f});
-    }
-    return true;
+    const auto radius = glm::length(local.max - local.min) * 0.5f * instance.scale;
+    const auto height = (local.min.y + local.max.y) * 0.5f * instance.scale;
+    const auto center = view_projection * glm::vec4(instance.position.x, height,
+                                                    instance.position.y, 1.0f);
+    // Measured at the near side of the sphere, so nothing is coarser than it looks
+    const auto depth = std::max(center.w - radius, 0.1f);
+    return select_lod_level(2.0f * radius * pixels_per_unit / depth, current_level, 128.0f);
 }
 
-void clamp_entity_to_curve(const glm::vec2& reference_point, Entity& entity)
+int main(int argc, char** argv)
 {
-    constexpr auto half_track_width = 9.0f;
-    const auto corner_to_entity = entity.position - reference_point;
-    const auto distance_to_reference = glm::length(corner_to_entity);
-
-    const auto adjusted_distance =
-        std::clamp(distance_to_reference, 30.0f - half_track_width, 30.0f + half_track_width);
+    const auto options = parse_options(argc, argv);
 
-    if (adjusted_distance != distance_to_reference) {
-        entity.position = reference_point + glm::normalize(corner_to_entity) * adjusted_distance;
-    }
-}
-
-int main(void)
-{
     /*
     const char* track_layout = {"r-;  \n"
                                 "| l-;\n"
@@ -413,270 +287,505 @@ const char* track_layout = {"   r;\n"
                                 "r-jl--j|\n"
                                 "l-s----j\n"};
                                 */
-    
-        const char* track_layout = {"   r;\n"
-                                    "r-;||\n"
-                                    "| lj|\n"
-                                    "l-s-j\n"};
+    const char* track_layout = default_track_layout;
                                     
 
-    glfwSetErrorCallback(error_callback);
-
-    if (!glfwInit())
-        exit(EXIT_FAILURE);
+    // Decoding overlaps with creating the window and loading the meshes
+    auto palette_image = load_texture_image_async("ImphenziaPalette01.png");
+    Texture palette;
+
+    GLFWwindow* window = NULL;
+    std::optional<HeadlessContext> headless;
+    if (options.headless) {
+        // Renders into an offscreen framebuffer, so there is nothing to swap and no vsync
+        headless.emplace(options.width, options.height);
+        if (!headless->is_valid())
+            exit(EXIT_FAILURE);
+    } else {
+        glfwSetErrorCallback(error_callback);
+
+        if (!glfwInit())
+            exit(EXIT_FAILURE);
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        window = glfwCreateWindow(640, 480, "OpenGL Triangle", NULL, NULL);
+        if (!window) {
+            glfwTerminate();
+            exit(EXIT_FAILURE);
+        }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwSetKeyCallback(window, key_callback);
 
-    GLFWwindow* window = glfwCreateWindow(640, 480, "OpenGL Triangle", NULL, NULL);
-    if (!window) {
-        glfwTerminate();
-        exit(EXIT_FAILURE);
+        glfwMakeContextCurrent(window);
+        gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+        glfwSwapInterval(1);
     }
 
-    glfwSetKeyCallback(window, key_callback);
-
-    glfwMakeContextCurrent(window);
-    gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
-    glfwSwapInterval(1);
-
     // NOTE: OpenGL error checks have been omitted for brevity
-    try_png("ImphenziaPalette01.png");
-
-    auto truck_verts = load_model("rc-truck.obj", "Cube");
-    auto tree_verts = load_model("tree.obj", "Tree");
-    decltype(truck_verts) track_verts;
 
-    auto track_segments = load_track_segments("track_segments.obj");
-    const auto track_segment_offsets = translate_track_layout(track_layout);
-
-    for (const auto& track_offset_row : track_segment_offsets) {
-        for (const auto& track_offset : track_offset_row) {
-            if (track_offset.track_segment.empty())
-                continue;
-            place_track_segment_with_offset_and_scale(track_segments[track_offset.track_segment],
-                                                      track_offset.offset, 10.0f, track_verts);
-        }
-    }
+    // Served from the baked .meshcache files when they are up to date
+    const MeshAssets truck_assets("rc-truck.obj");
+    const MeshAssets tree_assets("tree.obj");
+    // Segments are only ever drawn at full detail
+    const MeshAssets track_segments("track_segments.obj", false);
 
-    decltype(truck_verts) vertices;
-    vertices.reserve(truck_verts.size() + tree_verts.size());
-    std::copy(truck_verts.begin(), truck_verts.end(), std::back_inserter(vertices));
-    std::copy(tree_verts.begin(), tree_verts.end(), std::back_inserter(vertices));
-    std::copy(track_verts.begin(), track_verts.end(), std::back_inserter(vertices));
+    const auto track_tiles = translate_track_layout(track_layout);
+    const TrackDistanceField track_field(track_tiles);
 
-    size_t race_progress = 0;
-    const auto track_order = segment_order(track_segment_offsets);
-    const auto& starting_line =
-        track_segment_offsets[track_order[race_progress].first][track_order[race_progress].second];
+    const auto track_order = segment_order(track_tiles);
+    const auto& starting_line = track_tiles.at(track_order[0]);
 
-    const auto tree_count = track_segment_offsets.size() * track_segment_offsets[0].size();
+    const auto tree_count = track_tiles.rows() * track_tiles.columns();
     const auto trees_per_dimension = 4;
-    std::vector<Entity> entities(1);
-    entities.reserve(tree_count + 1);
+    std::vector<Prop> props;
+    props.reserve(tree_count);
     {
         std::random_device rd;
-        std::mt19937 mt(rd());
+        // Headless runs always scatter the same trees so their frames can be compared
+        std::mt19937 mt(options.headless ? 1u : rd());
         std::uniform_real_distribution<float> radian_dist(0, static_cast<float>(M_PI) * 2.f);
         std::uniform_real_distribution<float> distance_dist(-6.0f, 6.0f);
 
-        for (size_t i = 0; i < track_segment_offsets.size() * trees_per_dimension; ++i) {
-            for (size_t j = 0; j < track_segment_offsets[0].size() * trees_per_dimension; ++j) {
-                const float x =
-                    static_cast<float>(j) * (60.0f / static_cast<float>(trees_per_dimension)) -
-                    30.0f + distance_dist(mt);
-                const float y =
-                    static_cast<float>(i) * (60.0f / static_cast<float>(trees_per_dimension)) -
-                    30.0f + distance_dist(mt);
-                if (is_on_track({x, y}, 22, track_segment_offsets))
-                    continue;
-                entities.push_back({{x, y}, radian_dist(mt)});
+        // Every candidate spot is checked against the track in one batch
+        std::vector<float> xs;
+        std::vector<float> ys;
+        xs.reserve(tree_count * trees_per_dimension * trees_per_dimension);
+        ys.reserve(xs.capacity());
+        for (size_t i = 0; i < track_tiles.rows() * trees_per_dimension; ++i) {
+            for (size_t j = 0; j < track_tiles.columns() * trees_per_dimension; ++j) {
+                xs.push_back(static_cast<float>(j) *
+                                 (60.0f / static_cast<float>(trees_per_dimension)) -
+                             30.0f + distance_dist(mt));
+                ys.push_back(static_cast<float>(i) *
+                                 (60.0f / static_cast<float>(trees_per_dimension)) -
+                             30.0f + distance_dist(mt));
             }
         }
+        std::vector<uint8_t> on_track(xs.size());
+        // Trees keep a little clear of the edge of the track
+        constexpr float tree_clearance = 2.0f;
+        TrackQuery(track_field)
+            .on_track(xs.data(), ys.data(), xs.size(), tree_clearance, on_track.data());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            if (on_track[i])
+                continue;
+            props.push_back({{xs[i], ys[i]}, radian_dist(mt)});
+        }
     }
 
-    Entity& truck = entities[0];
-    truck.position = {starting_line.offset.x, starting_line.offset.z};
-    truck.angle = static_cast<float>(M_PI) / 2.0f;
-
-    TruckState truck_state;
-
-    GLuint vertex_buffer;
-    glGenBuffers(1, &vertex_buffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<int>(sizeof(vertices[0]) * vertices.size()),
-                 &vertices[0], GL_STATIC_DRAW);
-
-    const GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-
-    const auto vertex_shader_string = load_text_from("vertex.glsl");
-    const char* vertex_shader_text = vertex_shader_string.c_str();
-
-    glShaderSource(vertex_shader, 1, &vertex_shader_text, NULL);
-    glCompileShader(vertex_shader);
-
-    const GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-
-    const auto fragment_shader_string = load_text_from("fragment.glsl");
-    const char* fragment_shader_text = fragment_shader_string.c_str();
+    // The player's truck is vehicle 0. The computer's trucks start spread around the track,
+    // a few abreast on the middle of each segment, facing along it.
+    VehicleStore vehicles;
+    std::vector<RaceProgress> race_progress;
+    constexpr size_t player = 0;
+    {
+        TruckState start;
+        start.position = starting_line.centre;
+        start.angle = static_cast<float>(M_PI) / 2.0f;
+        vehicles.add(start);
+        race_progress.emplace_back();
+    }
+    for (size_t ai = 0; ai < options.ai_trucks; ++ai) {
+        const auto segment = (ai + 1) % track_order.size();
+        const auto& tile = track_tiles.at(track_order[segment]);
+        const auto& next = track_tiles.at(track_order[(segment + 1) % track_order.size()]);
+        // A curve's middle line passes between its tile's centre and its pivot, and runs at right
+        // angles to the way out from the pivot
+        const auto middle = nearest_middle_point(tile.centre, tile);
+        auto ahead = glm::normalize(next.centre - tile.centre);
+        if (traits_of(tile.type).shape == SegmentShape::curve) {
+            const auto outwards = glm::normalize(middle - tile.pivot);
+            const glm::vec2 along{-outwards.y, outwards.x};
+            ahead = glm::dot(along, ahead) >= 0 ? along : -along;
+        }
+        const glm::vec2 across{-ahead.y, ahead.x};
+        const auto abreast = static_cast<float>(ai / track_order.size() % 4) - 1.5f;
+
+        TruckState start;
+        start.position = middle + across * (abreast * 4.0f);
+        start.angle = std::atan2(-ahead.x, -ahead.y);
+        vehicles.add(start);
+        race_progress.emplace_back();
+        race_progress.back().segments_reached = segment;
+    }
 
-    glShaderSource(fragment_shader, 1, &fragment_shader_text, NULL);
-    glCompileShader(fragment_shader);
+    // The simulation runs in fixed ticks, and frames draw the trucks between the last two of them
+    FixedTimestep timestep(truck_tick_seconds);
 
-    const GLuint program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, fragment_shader);
-    glLinkProgram(program);
+    // Linked from the program cache when the sources and driver are unchanged. Attributes get
+    // fixed locations, so the vertex array below stays valid when the shaders are reloaded.
+    ShaderProgram shader("vertex.glsl", "fragment.glsl", "shaders.programcache",
+                         {"vPos", "vNorm", "vTex", "iPosition", "iAngle", "iScale"});
+    if (!shader.is_valid())
+        exit(EXIT_FAILURE);
 
-    const GLint mvp_location = glGetUniformLocation(program, "MVP");
-    const GLint model_location = glGetUniformLocation(program, "ModelMatrix");
-    const GLint vpos_location = glGetAttribLocation(program, "vPos");
-    const GLint vnorm_location = glGetAttribLocation(program, "vNorm");
-    const GLint vtex_location = glGetAttribLocation(program, "vTex");
+    GLint view_projection_location = -1;
+    const auto locate_uniforms = [&] {
+        view_projection_location = glGetUniformLocation(shader.id(), "ViewProjection");
+        glUseProgram(shader.id());
+        glUniform1i(glGetUniformLocation(shader.id(), "imphenzia"), 0);
+    };
+    locate_uniforms();
+    const GLint vpos_location = glGetAttribLocation(shader.id(), "vPos");
+    const GLint vnorm_location = glGetAttribLocation(shader.id(), "vNorm");
+    const GLint vtex_location = glGetAttribLocation(shader.id(), "vTex");
+    const InstanceAttributes instance_attributes{
+        static_cast<GLuint>(glGetAttribLocation(shader.id(), "iPosition")),
+        static_cast<GLuint>(glGetAttribLocation(shader.id(), "iAngle")),
+        static_cast<GLuint>(glGetAttribLocation(shader.id(), "iScale"))};
 
     GLuint vertex_array;
     glGenVertexArrays(1, &vertex_array);
     glBindVertexArray(vertex_array);
+
+    GLuint vertex_buffer;
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+
+    // The element buffer binding is part of the vertex array state
+    GLuint index_buffer;
+    glGenBuffers(1, &index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+
+    // Each segment type is uploaded once and placed on its tiles by instancing. The truck and
+    // trees bring every level of detail along.
+    std::vector<ModelView> meshes;
+    for (size_t level = 0; level < lod_level_count; ++level) {
+        meshes.push_back(truck_assets[lod_name("Cube", level)]);
+        meshes.push_back(tree_assets[lod_name("Tree", level)]);
+    }
+    // Every type but grass has a mesh
+    for (size_t type = 1; type < segment_type_count; ++type) {
+        meshes.push_back(track_segments[segment_traits[type].mesh_name]);
+    }
+    const auto mesh_ranges = upload_meshes(meshes);
+    std::array<MeshRange, lod_level_count> truck_lods;
+    std::array<MeshRange, lod_level_count> tree_lods;
+    for (size_t level = 0; level < lod_level_count; ++level) {
+        truck_lods[level] = mesh_ranges[2 * level];
+        tree_lods[level] = mesh_ranges[2 * level + 1];
+    }
+    std::array<MeshRange, segment_type_count> segment_ranges{};
+    for (size_t type = 1; type < segment_type_count; ++type) {
+        segment_ranges[type] = mesh_ranges[2 * lod_level_count + type - 1];
+    }
+
     glEnableVertexAttribArray(static_cast<GLuint>(vpos_location));
     glEnableVertexAttribArray(static_cast<GLuint>(vnorm_location));
     glEnableVertexAttribArray(static_cast<GLuint>(vtex_location));
-    glVertexAttribPointer(static_cast<GLuint>(vpos_location), 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+    glVertexAttribPointer(static_cast<GLuint>(vpos_location), 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                           (void*)offsetof(Vertex, pos));
-    glVertexAttribPointer(static_cast<GLuint>(vnorm_location), 3, GL_FLOAT, GL_FALSE,
+    glVertexAttribPointer(static_cast<GLuint>(vnorm_location), 4, GL_INT_2_10_10_10_REV, GL_TRUE,
                           sizeof(Vertex), (void*)offsetof(Vertex, norm));
-    glVertexAttribPointer(static_cast<GLuint>(vtex_location), 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                          (void*)offsetof(Vertex, tex));
+    glVertexAttribPointer(static_cast<GLuint>(vtex_location), 2, GL_UNSIGNED_SHORT, GL_TRUE,
+                          sizeof(Vertex), (void*)offsetof(Vertex, tex));
+
+    // The trucks move, so every frame they are sorted by level of detail into the head of the
+    // instance buffer. The trees and track tiles are split into chunks of the tile grid, and each
+    // chunk draws one batch per mesh if the camera can see it.
+    std::vector<Instance> instances(vehicles.size());
+    std::array<std::vector<Instance>, lod_level_count> lod_sorted_vehicles;
+    std::vector<size_t> vehicle_lod_levels(vehicles.size(), lod_level_count);
+
+    constexpr size_t tiles_per_chunk = 4;
+    WorldGrid world_grid(track_tiles.rows(), track_tiles.columns(), tiles_per_chunk);
+
+    // The track and the props on it are drawn, and timed, as separate passes
+    std::vector<Placement> track_placements;
+    place_track_tiles(track_tiles, segment_ranges, 10.0f, track_placements);
+    const auto track_chunk_batches = batch_by_chunk(track_placements, world_grid, instances);
+
+    std::vector<Placement> prop_placements;
+    for (const auto& prop : props) {
+        prop_placements.push_back({tree_lods[0], {prop.position, prop.angle}});
+    }
+    const size_t props_first = instances.size();
+    const auto prop_chunk_batches = batch_by_chunk(prop_placements, world_grid, instances);
+
+    // Every frame the visible trees are sorted by level of detail into the tail of the instance
+    // buffer, so that each level is drawn in a single call
+    const size_t lod_sorted_first = instances.size();
+    instances.resize(instances.size() + prop_placements.size());
+    std::array<std::vector<Instance>, lod_level_count> lod_sorted_props;
+    // The level each tree was last drawn at, by its place in the chunk batches
+    std::vector<size_t> prop_lod_levels(prop_placements.size(), lod_level_count);
+    std::vector<size_t> visible_chunks;
+
+    // Stays bound to GL_ARRAY_BUFFER so the trucks can be updated and batches selected each frame
+    GLuint instance_buffer;
+    glGenBuffers(1, &instance_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(Instance) * instances.size()),
+                 instances.data(), GL_DYNAMIC_DRAW);
+
+    glEnableVertexAttribArray(instance_attributes.position);
+    glEnableVertexAttribArray(instance_attributes.angle);
+    glEnableVertexAttribArray(instance_attributes.scale);
+    glVertexAttribDivisor(instance_attributes.position, 1);
+    glVertexAttribDivisor(instance_attributes.angle, 1);
+    glVertexAttribDivisor(instance_attributes.scale, 1);
 
     glm::vec2 camera_velocity{0};
-    glm::vec2 camera_target = truck.position;
+    glm::vec2 camera_target = vehicles.state(player).position;
     
-    double last_time = glfwGetTime();
-
-    std::string current_segment = "";
-    while (!glfwWindowShouldClose(window)) {
-        auto frame_time = glfwGetTime();
-        float delta_time = static_cast<float>(frame_time - last_time);
-        last_time = frame_time;
-
-        glfwPollEvents();
+    double last_time = options.headless ? 0 : glfwGetTime();
+
+    const InputScript input_script(options.input_filename.empty()
+                                       ? default_input_script
+                                       : load_text_from(options.input_filename.c_str()));
+    FrameReport frame_report;
+
+    Profiler profiler;
+    profiler.set_enabled(!options.profile_filename.empty());
+    GpuPassTimer track_pass_timer(profiler, "Track pass (GPU)");
+    GpuPassTimer entity_pass_timer(profiler, "Entity pass (GPU)");
+
+    size_t frame = 0;
+    while (options.headless ? frame < options.frames : !glfwWindowShouldClose(window)) {
+        const auto frame_start = std::chrono::steady_clock::now();
+        profiler.begin_frame(frame);
+        const ProfileScope frame_scope(profiler, "Frame");
+
+        double frame_seconds;
+        {
+            const ProfileScope input_scope(profiler, "Input");
+            if (options.headless) {
+                // Two ticks a frame keeps scripted runs identical no matter how fast they render
+                frame_seconds = 2 * truck_tick_seconds;
+                const auto input = input_script.at(frame);
+                holding_left = input.left;
+                holding_right = input.right;
+                holding_accel = input.accel;
+                holding_reverse = input.reverse;
+            } else {
+                auto frame_time = glfwGetTime();
+                frame_seconds = frame_time - last_time;
+                last_time = frame_time;
 
-        if (holding_left) {
-            truck.angle += 3.0f * delta_time;
-        } else if (holding_right) {
-            truck.angle -= 3.0f * delta_time;
+                glfwPollEvents();
+            }
         }
+        const auto delta_time = static_cast<float>(frame_seconds);
+
+        TruckState drawn_truck;
+        {
+            const ProfileScope physics_scope(profiler, "Physics");
+            const InputState input{holding_left, holding_right, holding_accel, holding_reverse};
+            for (auto ticks = timestep.advance(frame_seconds); ticks > 0; --ticks) {
+                // Progress is only read while the trucks step, and updated after
+                vehicles.step(track_field, ThreadPool::shared(),
+                              [&](size_t vehicle, const TruckState& state) {
+                                  return vehicle == player
+                                             ? input
+                                             : autopilot(state, race_progress[vehicle],
+                                                         track_tiles, track_order);
+                              });
+
+                for (size_t vehicle = 0; vehicle < vehicles.size(); ++vehicle) {
+                    auto& progress = race_progress[vehicle];
+                    if (progress.update(get_segment_coordinate(vehicles.state(vehicle).position,
+                                                               track_tiles),
+                                        track_order) &&
+                        vehicle == player) {
+                        std::cout << "Race Progress: " << progress.segments_reached << "\n";
+                        std::cout << "Lap: " << progress.laps_completed(track_order.size()) + 1
+                                  << std::endl;
+                        std::cout << std::endl;
+                    }
+                }
+            }
 
-        if (holding_accel) {
-            truck_state.power += truck_state.acceleration * delta_time;
-        } else {
-            truck_state.power -= truck_state.acceleration * 3.0f * delta_time;
+            drawn_truck = vehicles.interpolated(player, timestep.alpha());
         }
 
-        truck_state.power = std::clamp(truck_state.power, 0.0f, 1.0f);
-
-        auto direction = glm::rotate(glm::vec2{0.0f, -1.0f}, -truck.angle);
-        truck_state.velocity += direction * (truck_state.power * truck_state.max_power * delta_time);
-        truck_state.velocity += truck_state.velocity * (-truck_state.friction * delta_time);
-
-        truck.position += truck_state.velocity * delta_time;
-
-        const auto track_offset_coordinate =
-            get_segment_coordinate(truck.position, track_segment_offsets);
-        const auto& track_offset =
-            track_segment_offsets[track_offset_coordinate.first][track_offset_coordinate.second];
-
-        const auto next_segment_index = (race_progress + 1) % track_order.size();
-        if (track_offset_coordinate == track_order[next_segment_index]) {
-            // When we reach the next segment, we can advance the race_progress
-            race_progress++;
-            std::cout << "Race Progress: " << race_progress << "\n";
-            std::cout << "Lap: " << ((race_progress - 1) / track_order.size() + 1) << std::endl;
-            std::cout << std::endl;
+        int width = options.width;
+        int height = options.height;
+        if (window)
+            glfwGetFramebufferSize(window, &width, &height);
+
+        glm::mat4 view_projection;
+        float pixels_per_unit;
+        {
+            const ProfileScope camera_scope(profiler, "Camera");
+            auto moving_target = drawn_truck.position + (drawn_truck.velocity * 0.2f);
+            auto vector_to_truck = (moving_target - camera_target);
+            float distance_to_camera_target = glm::length(vector_to_truck);
+            camera_velocity = vector_to_truck * 9.0f;
+            camera_target += camera_velocity * delta_time;
+
+            const float ratio = width / (float)height;
+
+            glm::mat4 view{1.0f};
+            view = glm::translate(view,
+                                  glm::vec3(0, 0, -(30.0f + distance_to_camera_target * 2.0f)));
+            view = glm::rotate(view, glm::radians(35.264f), glm::vec3(1.0f, 0, 0));
+            view = glm::rotate(view, glm::radians(-45.0f), glm::vec3(0, 1.0f, 0));
+            view = glm::translate(view, glm::vec3(-camera_target.x, 0, -camera_target.y));
+
+            glm::mat4 projection = glm::perspective(glm::radians(35.f), ratio, 0.1f, 100.0f);
+            view_projection = projection * view;
+            pixels_per_unit = projection[1][1] * 0.5f * static_cast<float>(height);
         }
 
-        if (track_offset.track_segment != current_segment) {
-            current_segment = track_offset.track_segment;
-        }
+        FrameStats frame_stats;
+        {
+            const ProfileScope render_scope(profiler, "Render");
+            glViewport(0, 0, width, height);
+            glEnable(GL_DEPTH_TEST);
+
+            glClearColor(0.33f, 0.72f, 0.36f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // Until the palette has loaded, geometry samples the empty texture and shows black.
+            // Headless runs wait for it so that every frame is reproducible.
+            if (palette_image.valid() &&
+                (options.headless || palette_image.wait_for(std::chrono::seconds(0)) ==
+                                         std::future_status::ready)) {
+                if (const auto image = palette_image.get()) {
+                    palette = upload_texture(*image);
+                }
+            }
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, palette.name());
 
-        constexpr auto track_width = 18.0f;
-        constexpr auto half_track_width = track_width / 2.0f;
-        if (current_segment == "Vertical") {
-            truck.position.x =
-                std::clamp(truck.position.x, track_offset.offset.x - half_track_width,
-                           track_offset.offset.x + half_track_width);
-        } else if (current_segment == "Horizontal" || current_segment == "Starting_Line") {
-            truck.position.y =
-                std::clamp(truck.position.y, track_offset.offset.z - half_track_width,
-                           track_offset.offset.z + half_track_width);
-        } else if (current_segment == "Top_Left") {
-            clamp_entity_to_curve({track_offset.offset.x + 30.0f, track_offset.offset.z + 30.0f},
-                                  truck);
-        } else if (current_segment == "Top_Right") {
-            clamp_entity_to_curve({track_offset.offset.x - 30.0f, track_offset.offset.z + 30.0f},
-                                  truck);
-        } else if (current_segment == "Bottom_Right") {
-            clamp_entity_to_curve({track_offset.offset.x - 30.0f, track_offset.offset.z - 30.0f},
-                                  truck);
-        } else if (current_segment == "Bottom_Left") {
-            clamp_entity_to_curve({track_offset.offset.x + 30.0f, track_offset.offset.z - 30.0f},
-                                  truck);
+            // Edited shaders are picked up without a restart
+            if (!options.headless && shader.reload_if_changed()) {
+                locate_uniforms();
+            }
+            glUseProgram(shader.id());
+            glUniformMatrix4fv(view_projection_location, 1, GL_FALSE,
+                               glm::value_ptr(view_projection));
+            glBindVertexArray(vertex_array);
+            const Frustum frustum(view_projection);
+            visible_chunks.clear();
+            world_grid.visible_chunks(frustum, visible_chunks);
+
+            {
+                const ProfileScope track_scope(profiler, "Track pass");
+                track_pass_timer.begin();
+                for (const auto chunk : visible_chunks) {
+                    for (const auto& batch : track_chunk_batches[chunk]) {
+                        draw_batch(batch, instance_attributes, frame_stats);
+                    }
+                }
+                track_pass_timer.end();
+            }
+            {
+                const ProfileScope entity_scope(profiler, "Entity pass");
+                entity_pass_timer.begin();
+                for (auto& sorted : lod_sorted_props) {
+                    sorted.clear();
+                }
+                for (const auto chunk : visible_chunks) {
+                    for (const auto& batch : prop_chunk_batches[chunk]) {
+                        for (size_t i = 0; i < batch.instance_count; ++i) {
+                            const auto& instance = instances[batch.first_instance + i];
+                            auto& level = prop_lod_levels[batch.first_instance + i - props_first];
+                            level = lod_level_at(view_projection, pixels_per_unit,
+                                                 batch.mesh.bounds, instance, level);
+                            lod_sorted_props[level].push_back(instance);
+                        }
+                    }
+                }
+                // The props are all trees
+                size_t first_instance = lod_sorted_first;
+                for (size_t level = 0; level < lod_level_count; ++level) {
+                    const auto& sorted = lod_sorted_props[level];
+                    if (sorted.empty()) {
+                        continue;
+                    }
+                    glBufferSubData(GL_ARRAY_BUFFER,
+                                    static_cast<GLintptr>(sizeof(Instance) * first_instance),
+                                    static_cast<GLsizeiptr>(sizeof(Instance) * sorted.size()),
+                                    sorted.data());
+                    draw_mesh_instanced(tree_lods[level], instance_attributes, first_instance,
+                                        sorted.size(), frame_stats);
+                    first_instance += sorted.size();
+                }
+
+                // The trucks are the only instances that need uploading each frame
+                for (auto& sorted : lod_sorted_vehicles) {
+                    sorted.clear();
+                }
+                for (size_t vehicle = 0; vehicle < vehicles.size(); ++vehicle) {
+                    const auto drawn = vehicle == player
+                                           ? drawn_truck
+                                           : vehicles.interpolated(vehicle, timestep.alpha());
+                    const Instance instance{drawn.position, drawn.angle};
+                    if (!frustum.intersects(
+                            placed_bounds(truck_lods[0].bounds, instance.position, 1.0f))) {
+                        continue;
+                    }
+                    auto& level = vehicle_lod_levels[vehicle];
+                    level = lod_level_at(view_projection, pixels_per_unit, truck_lods[0].bounds,
+                                         instance, level);
+                    lod_sorted_vehicles[level].push_back(instance);
+                }
+                size_t first_vehicle = 0;
+                for (size_t level = 0; level < lod_level_count; ++level) {
+                    const auto& sorted = lod_sorted_vehicles[level];
+                    if (sorted.empty()) {
+                        continue;
+                    }
+                    glBufferSubData(GL_ARRAY_BUFFER,
+                                    static_cast<GLintptr>(sizeof(Instance) * first_vehicle),
+                                    static_cast<GLsizeiptr>(sizeof(Instance) * sorted.size()),
+                                    sorted.data());
+                    draw_mesh_instanced(truck_lods[level], instance_attributes, first_vehicle,
+                                        sorted.size(), frame_stats);
+                    first_vehicle += sorted.size();
+                }
+                entity_pass_timer.end();
+            }
         }
 
-        auto moving_target = truck.position + (truck_state.velocity * 0.2f);
-        auto vector_to_truck = (moving_target - camera_target);
-        float distance_to_camera_target = glm::length(vector_to_truck);
-        camera_velocity = vector_to_truck * 9.0f;
-        camera_target += camera_velocity * delta_time;
-
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
-        const float ratio = width / (float)height;
-
-        glViewport(0, 0, width, height);
-        glEnable(GL_DEPTH_TEST);
-
-        glClearColor(0.33f, 0.72f, 0.36f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        glm::mat4 view{1.0f};
-        view = glm::translate(view, glm::vec3(0, 0, -(30.0f + distance_to_camera_target * 2.0f)));
-        view = glm::rotate(view, glm::radians(35.264f), glm::vec3(1.0f, 0, 0));
-        view = glm::rotate(view, glm::radians(-45.0f), glm::vec3(0, 1.0f, 0));
-        view = glm::translate(view, glm::vec3(-camera_target.x, 0, -camera_target.y));
-
-        glm::mat4 track_model = glm::mat4{1.0};
-        glm::mat4 projection = glm::perspective(glm::radians(35.f), ratio, 0.1f, 100.0f);
-
-        glm::mat4 track_mvp = projection * view;
-        glUseProgram(program);
-        glUniformMatrix4fv(mvp_location, 1, GL_FALSE, glm::value_ptr(track_mvp));
-        glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(track_model));
-        glBindVertexArray(vertex_array);
-        glDrawArrays(GL_TRIANGLES, static_cast<int>(truck_verts.size() + tree_verts.size()),
-                     static_cast<int>(track_verts.size()));
-
-        for (const auto& entity : entities) {
-            glm::mat4 model = model_matrix_from_entity(entity);
-            glm::mat4 mvp = projection * view * model;
-
-            glUseProgram(program);
-            glUniformMatrix4fv(mvp_location, 1, GL_FALSE, glm::value_ptr(mvp));
-            glUniformMatrix4fv(model_location, 1, GL_FALSE, glm::value_ptr(model));
-            glBindVertexArray(vertex_array);
+        if (options.headless) {
+            // Wait for the frame to finish rendering, as a swap would, so the time includes it
+            glFinish();
+            const std::chrono::duration<double, std::milli> frame_duration =
+                std::chrono::steady_clock::now() - frame_start;
+            frame_report.add(frame_duration.count(), frame_stats);
+
+            if (std::find(options.dump_frames.begin(), options.dump_frames.end(), frame) !=
+                options.dump_frames.end()) {
+                const auto filename = options.dump_prefix + std::to_string(frame) + ".png";
+                if (!write_framebuffer_png(filename.c_str(), width, height)) {
+                    fprintf(stderr, "Error: unable to write %s\n", filename.c_str());
+                }
+            }
+        } else {
+            const ProfileScope swap_scope(profiler, "Swap");
+            glfwSwapBuffers(window);
+        }
 
-            if (&entity == &truck) {
-                glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(truck_verts.size()));
-            } else {
-                glDrawArrays(GL_TRIANGLES, static_cast<int>(truck_verts.size()),
-                             static_cast<int>(tree_verts.size()));
+        // F12 only saves a trace when --profile gave somewhere to save it
+        if (dump_profile_requested) {
+            dump_profile_requested = false;
+            if (profiler.enabled()) {
+                write_profile(profiler, options.profile_filename);
             }
         }
-        glfwSwapBuffers(window);
+        ++frame;
+    }
+
+    if (profiler.enabled()) {
+        write_profile(profiler, options.profile_filename);
     }
 
-    glfwDestroyWindow(window);
+    // GL objects have to go before the context that owns them
+    palette.reset();
 
-    glfwTerminate();
+    if (options.headless) {
+        std::ofstream report(options.report_filename);
+        frame_report.write(report);
+        frame_report.write(std::cout);
+        headless.reset();
+    } else {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
     exit(EXIT_SUCCESS);
 }
\ No newline at end of file
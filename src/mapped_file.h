@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of an entire file. The pages are mapped straight from the OS file cache, so
+// large assets are never copied onto the heap.
+class MappedFile {
+  public:
+    explicit MappedFile(const char* filename) { map(filename); }
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : _data(other._data), _size(other._size), _is_open(other._is_open)
+    {
+        other._data = nullptr;
+        other._size = 0;
+        other._is_open = false;
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            unmap();
+            _data = other._data;
+            _size = other._size;
+            _is_open = other._is_open;
+            other._data = nullptr;
+            other._size = 0;
+            other._is_open = false;
+        }
+        return *this;
+    }
+
+    // An empty file is open, but has no mapping behind it.
+    bool is_open() const { return _is_open; }
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+    std::string_view text() const { return {_data, _size}; }
+
+  private:
+#ifdef _WIN32
+    void map(const char* filename)
+    {
+        HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                  FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file, &file_size)) {
+            _is_open = true;
+            if (file_size.QuadPart > 0) {
+                HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (mapping) {
+                    _data = static_cast<const char*>(
+                        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    _size = _data ? static_cast<size_t>(file_size.QuadPart) : 0;
+                    _is_open = _data != nullptr;
+                    CloseHandle(mapping);
+                } else {
+                    _is_open = false;
+                }
+            }
+        }
+        CloseHandle(file);
+    }
+
+    void unmap()
+    {
+        if (_data) {
+            UnmapViewOfFile(_data);
+        }
+    }
+#else
+    void map(const char* filename)
+    {
+        const int fd = open(filename, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == 0) {
+            _is_open = true;
+            if (file_stat.st_size > 0) {
+                const auto file_size = static_cast<size_t>(file_stat.st_size);
+                void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    // We parse front to back exactly once; let the kernel read ahead aggressively.
+                    madvise(mapping, file_size, MADV_SEQUENTIAL);
+                    _data = static_cast<const char*>(mapping);
+                    _size = file_size;
+                } else {
+                    _is_open = false;
+                }
+            }
+        }
+        close(fd);
+    }
+
+    void unmap()
+    {
+        if (_data) {
+            munmap(const_cast<char*>(_data), _size);
+        }
+    }
+#endif
+
+    const char* _data = nullptr;
+    size_t _size = 0;
+    bool _is_open = false;
+};
+
+inline uint64_t fnv1a_64(std::string_view bytes)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline std::optional<uint64_t> hash_file(const char* filename)
+{
+    const MappedFile file(filename);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    return fnv1a_64(file.text());
+}
@@ -0,0 +1,52 @@
+// Offline baker: parses an OBJ file and writes every object in it, along with its simplified
+// levels of detail, to a mesh cache that the game can map and upload without parsing.
+//
+//   mesh_baker [--no-lod] <input.obj> [<output.meshcache>]
+//
+// The output defaults to <input.obj>.meshcache, which is where the game looks for it. --no-lod
+// leaves out the simplified levels, for meshes that are always drawn at full detail.
+#include "mesh_cache.h"
+
+#include <string>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char** argv)
+{
+    const bool with_lod_levels = !(argc > 1 && std::string(argv[1]) == "--no-lod");
+    const int first_argument = with_lod_levels ? 1 : 2;
+    if (argc - first_argument < 1 || argc - first_argument > 2) {
+        fprintf(stderr, "Usage: %s [--no-lod] <input.obj> [<output.meshcache>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* obj_filename = argv[first_argument];
+    const auto cache_filename = argc - first_argument == 2 ? std::string(argv[first_argument + 1])
+                                                           : mesh_cache_filename(obj_filename);
+
+    const auto source_hash = hash_file(obj_filename);
+    if (!source_hash) {
+        fprintf(stderr, "Error: unable to open %s\n", obj_filename);
+        return EXIT_FAILURE;
+    }
+
+    auto models = load_models(obj_filename);
+    if (with_lod_levels) {
+        add_lod_levels(models);
+    }
+    if (!write_mesh_cache(cache_filename.c_str(), *source_hash, models)) {
+        fprintf(stderr, "Error: unable to write %s\n", cache_filename.c_str());
+        return EXIT_FAILURE;
+    }
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    for (const auto& [name, model] : models) {
+        vertex_count += model.vertices.size();
+        index_count += model.indices.size();
+    }
+    printf("%s: %zu meshes, %zu vertices, %zu indices\n", cache_filename.c_str(), models.size(),
+           vertex_count, index_count);
+    return EXIT_SUCCESS;
+}
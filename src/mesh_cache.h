@@ -0,0 +1,225 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "model.h"
+#include "simplify.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Baked meshes are stored as
+//
+//   MeshCacheHeader
+//   MeshCacheEntry[mesh_count]
+//   names, vertex and index blobs, each starting on a 16 byte boundary
+//
+// All offsets are from the start of the file. Vertices are stored exactly as they are uploaded to
+// the GPU, so a loaded cache can be handed to glBufferData without being touched.
+constexpr char mesh_cache_magic[4] = {'R', 'C', 'M', 'C'};
+constexpr uint32_t mesh_cache_version = 3;
+
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertex_size;
+    uint32_t mesh_count;
+    // FNV-1a hash of the OBJ file the cache was baked from.
+    uint64_t source_hash;
+};
+
+struct MeshCacheEntry {
+    uint64_t name_offset;
+    uint64_t name_size;
+    uint64_t vertex_offset;
+    uint64_t vertex_count;
+    uint64_t index_offset;
+    uint64_t index_count;
+};
+
+inline std::string mesh_cache_filename(const char* obj_filename)
+{
+    return std::string(obj_filename) + ".meshcache";
+}
+
+inline bool write_mesh_cache(const char* filename, uint64_t source_hash,
+                             const std::map<std::string, Model>& models)
+{
+    constexpr size_t alignment = 16;
+    const auto align = [](size_t offset) { return (offset + alignment - 1) & ~(alignment - 1); };
+
+    std::vector<MeshCacheEntry> entries;
+    size_t offset = sizeof(MeshCacheHeader) + sizeof(MeshCacheEntry) * models.size();
+    for (const auto& [name, model] : models) {
+        MeshCacheEntry entry;
+        entry.name_offset = offset = align(offset);
+        entry.name_size = name.size();
+        offset += name.size();
+        entry.vertex_offset = offset = align(offset);
+        entry.vertex_count = model.vertices.size();
+        offset += sizeof(Vertex) * model.vertices.size();
+        entry.index_offset = offset = align(offset);
+        entry.index_count = model.indices.size();
+        offset += sizeof(uint32_t) * model.indices.size();
+        entries.push_back(entry);
+    }
+
+    std::vector<char> bytes(offset);
+    MeshCacheHeader header;
+    std::memcpy(header.magic, mesh_cache_magic, sizeof(header.magic));
+    header.version = mesh_cache_version;
+    header.vertex_size = sizeof(Vertex);
+    header.mesh_count = static_cast<uint32_t>(models.size());
+    header.source_hash = source_hash;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    if (!entries.empty()) {
+        std::memcpy(bytes.data() + sizeof(header), entries.data(),
+                    sizeof(MeshCacheEntry) * entries.size());
+    }
+
+    auto entry = entries.begin();
+    for (const auto& [name, model] : models) {
+        std::memcpy(bytes.data() + entry->name_offset, name.data(), name.size());
+        std::memcpy(bytes.data() + entry->vertex_offset, model.vertices.data(),
+                    sizeof(Vertex) * model.vertices.size());
+        std::memcpy(bytes.data() + entry->index_offset, model.indices.data(),
+                    sizeof(uint32_t) * model.indices.size());
+        ++entry;
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+// Read-only, zero-copy view of a baked mesh cache.
+class MeshCache {
+  public:
+    // Fails validation if the file is missing, malformed, from another format version, or was
+    // baked from something other than `source_hash`.
+    MeshCache(const char* filename, uint64_t source_hash) : _file(filename)
+    {
+        if (!_file.is_open() || _file.size() < sizeof(MeshCacheHeader)) {
+            return;
+        }
+        MeshCacheHeader header;
+        std::memcpy(&header, _file.data(), sizeof(header));
+        if (std::memcmp(header.magic, mesh_cache_magic, sizeof(header.magic)) != 0 ||
+            header.version != mesh_cache_version || header.vertex_size != sizeof(Vertex) ||
+            header.source_hash != source_hash ||
+            _file.size() < sizeof(header) + sizeof(MeshCacheEntry) * header.mesh_count) {
+            return;
+        }
+
+        const auto* entries =
+            reinterpret_cast<const MeshCacheEntry*>(_file.data() + sizeof(MeshCacheHeader));
+        for (uint32_t i = 0; i < header.mesh_count; ++i) {
+            const auto& entry = entries[i];
+            if (!fits(entry.name_offset, entry.name_size, 1, 1) ||
+                !fits(entry.vertex_offset, entry.vertex_count, sizeof(Vertex), alignof(Vertex)) ||
+                !fits(entry.index_offset, entry.index_count, sizeof(uint32_t),
+                      alignof(uint32_t))) {
+                _meshes.clear();
+                return;
+            }
+            _meshes[std::string(_file.data() + entry.name_offset, entry.name_size)] = &entry;
+        }
+        _is_valid = true;
+    }
+
+    bool is_valid() const { return _is_valid; }
+
+    std::vector<std::string> names() const
+    {
+        std::vector<std::string> result;
+        for (const auto& mesh : _meshes) {
+            result.push_back(mesh.first);
+        }
+        return result;
+    }
+
+    // Throws std::out_of_range if there is no mesh called `name`.
+    ModelView operator[](const std::string& name) const
+    {
+        const auto& entry = *_meshes.at(name);
+        return {reinterpret_cast<const Vertex*>(_file.data() + entry.vertex_offset),
+                static_cast<size_t>(entry.vertex_count),
+                reinterpret_cast<const uint32_t*>(_file.data() + entry.index_offset),
+                static_cast<size_t>(entry.index_count)};
+    }
+
+  private:
+    // Whether `count` items of `item_size` bytes starting at `offset` lie within the file, with
+    // the first one aligned so it can be read in place. Written so a forged offset or count
+    // cannot wrap around.
+    bool fits(uint64_t offset, uint64_t count, size_t item_size, size_t alignment) const
+    {
+        return offset <= _file.size() && offset % alignment == 0 &&
+               count <= (_file.size() - offset) / item_size;
+    }
+
+    MappedFile _file;
+    std::map<std::string, const MeshCacheEntry*> _meshes;
+    bool _is_valid = false;
+};
+
+// The meshes of one OBJ file. They are served straight out of its baked cache when that is still
+// up to date, and parsed from the OBJ otherwise.
+//
+// If the OBJ itself is missing, there is nothing to check the cache against, so it is trusted
+// as-is and can be stale. This lets packs ship without their sources. The cache is still
+// checked for a matching format and for offsets that stay inside the file.
+//
+// Meshes parsed from the OBJ get simplified levels of detail unless `with_lod_levels` is false,
+// for meshes that are always drawn at full detail. Caches are baked to match by mesh_baker.
+class MeshAssets {
+  public:
+    explicit MeshAssets(const char* obj_filename, bool with_lod_levels = true)
+    {
+        const auto cache_filename = mesh_cache_filename(obj_filename);
+        const auto source_hash = hash_file(obj_filename);
+        if (source_hash) {
+            _cache.emplace(cache_filename.c_str(), *source_hash);
+        } else {
+            _cache.emplace(cache_filename.c_str(), cached_source_hash(cache_filename.c_str()));
+        }
+        if (!_cache->is_valid()) {
+            _cache.reset();
+            _models = load_models(obj_filename);
+            if (with_lod_levels) {
+                add_lod_levels(_models);
+            }
+        }
+    }
+
+    bool from_cache() const { return _cache.has_value(); }
+
+    // Throws std::out_of_range if there is no mesh called `name`.
+    ModelView operator[](const std::string& name) const
+    {
+        return _cache ? (*_cache)[name] : _models.at(name).view();
+    }
+
+  private:
+    static uint64_t cached_source_hash(const char* cache_filename)
+    {
+        const MappedFile file(cache_filename);
+        MeshCacheHeader header{};
+        if (file.size() >= sizeof(header)) {
+            std::memcpy(&header, file.data(), sizeof(header));
+        }
+        return header.source_hash;
+    }
+
+    std::optional<MeshCache> _cache;
+    std::map<std::string, Model> _models;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "load_obj.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+// The vertex layout shared by the mesh cache and the GPU, 20 bytes where full floats would take
+// 36. Position stays in floats since track segments are scaled up by the instance transform.
+struct Vertex {
+    glm::vec3 pos;    // w is always 1, so the shader supplies it
+    uint32_t norm;    // GL_INT_2_10_10_10_REV, normalised
+    uint16_t tex[2];  // GL_UNSIGNED_SHORT, normalised to [0, 1]
+};
+static_assert(sizeof(Vertex) == 20, "Vertex must stay tightly packed for the GPU and mesh cache");
+
+// Packs a unit normal into three signed 10 bit fields with x in the lowest bits.
+inline uint32_t pack_normal(const glm::vec3& n)
+{
+    const auto field = [](float value) {
+        const auto quantized =
+            static_cast<int32_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 511.0f));
+        return static_cast<uint32_t>(quantized) & 0x3FFu;
+    };
+    return field(n.x) | field(n.y) << 10 | field(n.z) << 20;
+}
+
+inline glm::vec3 unpack_normal(uint32_t packed)
+{
+    const auto field = [&](int shift) {
+        // Move the field to the top so the arithmetic shift back down sign extends it
+        const auto value = static_cast<int32_t>(packed << (22 - shift)) >> 22;
+        return std::max(static_cast<float>(value) / 511.0f, -1.0f);
+    };
+    return {field(0), field(10), field(20)};
+}
+
+inline uint16_t pack_unorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline float unpack_unorm16(uint16_t value) { return static_cast<float>(value) / 65535.0f; }
+
+// Non-owning view of a mesh's vertices and triangle indices, wherever they happen to live.
+struct ModelView {
+    const Vertex* vertices;
+    size_t vertex_count;
+    const uint32_t* indices;
+    size_t index_count;
+};
+
+// Vertices and the triangle indices into them
+struct Model {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    ModelView view() const
+    {
+        return {vertices.data(), vertices.size(), indices.data(), indices.size()};
+    }
+};
+
+inline Model model_from_mesh(const ObjFile::IndexedMesh<uint32_t>& mesh)
+{
+    Model result;
+    result.vertices.reserve(mesh.vertices.size());
+    for (const auto& vertex : mesh.vertices) {
+        const auto& v = vertex.position;
+        const auto& t = vertex.tex;
+        const auto& n = vertex.normal;
+        // The palette texture only needs coarse coordinates, so they fit normalised 16 bit
+        // integers. w is dropped since nothing renders rational vertices.
+        result.vertices.push_back({{v.x, v.y, v.z},
+                                   pack_normal({n.x, n.y, n.z}),
+                                   {pack_unorm16(t.u), pack_unorm16(1.0f - t.v)}});
+    }
+    result.indices = mesh.indices;
+    return result;
+}
+
+// Parses every object in an OBJ file into a Model.
+inline std::map<std::string, Model> load_models(const char* filename)
+{
+    ObjFile obj;
+    if (!obj.process_file(filename, &ThreadPool::shared())) {
+        fprintf(stderr, "Error: unable to open %s\n", filename);
+    }
+
+    std::map<std::string, Model> result;
+    for (const auto& obj_name : obj.objects()) {
+        result[obj_name] = model_from_mesh(obj.produce_indexed_mesh(obj_name));
+    }
+    return result;
+}
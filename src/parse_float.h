@@ -0,0 +1,146 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Float parsing for OBJ records. Blender writes every coordinate as a short fixed-point decimal
+// such as `-0.833333`, which is parsed here exactly without going through std::from_chars.
+
+namespace parse_float_detail {
+
+inline int count_trailing_zeros(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Unaligned loads that put the first byte in the lowest bits on any host.
+inline uint64_t load_little_endian_64(const char* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+inline uint32_t load_little_endian_32(const char* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+constexpr uint64_t repeat_byte(uint8_t b) { return 0x0101010101010101ull * b; }
+
+// Reads up to 8 leading decimal digits of `s` at once, treating the 8 bytes as one 64 bit word
+// (SWAR). Returns how many digits there were and stores their value in `value`.
+inline size_t parse_eight_digits(std::string_view s, uint32_t& value)
+{
+    // Load the token's first 8 bytes without reading past its end. Missing bytes stay 0, which
+    // is not a digit.
+    uint64_t word = 0;
+    if (s.size() >= 8) {
+        word = load_little_endian_64(s.data());
+    } else if (s.size() >= 4) {
+        // Two overlapping loads cover 4 to 7 bytes without a round trip through memory.
+        const uint64_t low = load_little_endian_32(s.data());
+        const uint64_t high = load_little_endian_32(s.data() + s.size() - 4);
+        word = low | high << ((s.size() - 4) * 8);
+    } else {
+        for (size_t i = 0; i < s.size(); ++i) {
+            word |= static_cast<uint64_t>(static_cast<unsigned char>(s[i])) << (i * 8);
+        }
+    }
+
+    // Digits become 0-9. Any byte that is now 10 or more gets its top bit set by the add, and
+    // carries only ever run towards later bytes, so the first flagged byte is always accurate.
+    auto digits = word ^ repeat_byte('0');
+    const auto non_digits = ((digits + repeat_byte(0x76)) | digits) & repeat_byte(0x80);
+    const auto count = non_digits ? static_cast<size_t>(count_trailing_zeros(non_digits) / 8) : 8;
+    if (count == 0) {
+        value = 0;
+        return 0;
+    }
+
+    // Shift the digits to the top of the word, which pads them with leading zeros, then combine
+    // neighbouring bytes into 2, 4 and finally 8 digit numbers.
+    digits <<= (8 - count) * 8;
+    digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFull;
+    digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFull;
+    digits = (digits * 10000 + (digits >> 32)) & 0x00000000FFFFFFFFull;
+    value = static_cast<uint32_t>(digits);
+    return count;
+}
+
+constexpr float powers_of_ten[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f};
+
+} // namespace parse_float_detail
+
+// Parses `[-]digits[.digits]` when the result can be rounded exactly with a single float
+// division: the digits, read as one integer, fit in a float's 24 bit mantissa and there are at
+// most 8 of them after the point. Both operands are then exact, so IEEE division rounds the
+// quotient correctly. Returns false, leaving `value` untouched, for anything else.
+inline bool parse_fixed_point_float(std::string_view token, float& value)
+{
+    using namespace parse_float_detail;
+
+    const bool negative = !token.empty() && token.front() == '-';
+    if (negative) {
+        token.remove_prefix(1);
+    }
+
+    uint32_t integer_part;
+    const auto integer_digits = parse_eight_digits(token, integer_part);
+    token.remove_prefix(integer_digits);
+
+    uint32_t fraction_part = 0;
+    size_t fraction_digits = 0;
+    if (!token.empty() && token.front() == '.') {
+        token.remove_prefix(1);
+        fraction_digits = parse_eight_digits(token, fraction_part);
+        token.remove_prefix(fraction_digits);
+    }
+
+    // Anything left over is an exponent, a 9th digit, or not a number at all.
+    if (!token.empty() || integer_digits + fraction_digits == 0) {
+        return false;
+    }
+
+    const auto mantissa = static_cast<uint64_t>(integer_part) *
+                              static_cast<uint64_t>(powers_of_ten[fraction_digits]) +
+                          fraction_part;
+    if (mantissa >= (uint64_t{1} << 24)) {
+        return false;
+    }
+
+    const float magnitude = static_cast<float>(mantissa) / powers_of_ten[fraction_digits];
+    value = negative ? -magnitude : magnitude;
+    return true;
+}
+
+// Exactly rounded float parse that takes the fixed-point fast path when it can and falls back to
+// std::from_chars otherwise. Like `operator>>`, a missing or malformed value leaves `fallback`
+// untouched.
+inline float parse_float(std::string_view token, float fallback = 0)
+{
+    if (!token.empty() && token.front() == '+') {
+        token.remove_prefix(1);
+    }
+    float value = fallback;
+    if (!parse_fixed_point_float(token, value)) {
+        std::from_chars(token.data(), token.data() + token.size(), value);
+    }
+    return value;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <vector>
+
+// Records timed events from the main loop into a fixed size ring buffer, so that the most recent
+// frames can be exported as a Chrome trace (chrome://tracing or https://ui.perfetto.dev) after a
+// hitch. While disabled, recording costs a single branch.
+class Profiler {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // Timelines shown as separate threads in the trace
+    enum class Track : uint32_t { cpu, gpu };
+
+    struct Event {
+        const char* name; // Must outlive the profiler, e.g. a string literal
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        uint64_t frame;
+        Track track;
+    };
+
+    explicit Profiler(size_t capacity = 1 << 14) : _events(capacity > 0 ? capacity : 1) {}
+
+    bool enabled() const { return _enabled; }
+    void set_enabled(bool enabled) { _enabled = enabled; }
+
+    // Events recorded from now on belong to `frame`
+    void begin_frame(uint64_t frame) { _frame = frame; }
+    uint64_t frame() const { return _frame; }
+
+    // Nanoseconds since the profiler was created
+    uint64_t now() const { return since_epoch(Clock::now()); }
+
+    uint64_t since_epoch(Clock::time_point time) const
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(time - _epoch).count());
+    }
+
+    // Overwrites the oldest event once the buffer is full.
+    void record(const char* name, uint64_t start_ns, uint64_t duration_ns, Track track,
+                uint64_t frame)
+    {
+        if (!_enabled) {
+            return;
+        }
+        _events[_next] = {name, start_ns, duration_ns, frame, track};
+        _next = (_next + 1) % _events.size();
+        _size = std::min(_size + 1, _events.size());
+    }
+
+    size_t size() const { return _size; }
+
+    // The recorded events from oldest to newest
+    std::vector<Event> events() const
+    {
+        std::vector<Event> result;
+        result.reserve(_size);
+        const auto first = (_next + _events.size() - _size) % _events.size();
+        for (size_t i = 0; i < _size; ++i) {
+            result.push_back(_events[(first + i) % _events.size()]);
+        }
+        return result;
+    }
+
+    // Writes the events in Chrome's trace event format, as complete ("X") events in
+    // microseconds. Event names are written as they are, so they must not need JSON escaping.
+    void write_chrome_trace(std::ostream& os) const
+    {
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,"
+              "\"args\":{\"name\":\"CPU\"}},\n";
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,"
+              "\"args\":{\"name\":\"GPU\"}}";
+        for (const auto& event : events()) {
+            os << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+               << static_cast<uint32_t>(event.track)
+               << ",\"ts\":" << Microseconds{event.start_ns}
+               << ",\"dur\":" << Microseconds{event.duration_ns}
+               << ",\"args\":{\"frame\":" << event.frame << "}}";
+        }
+        os << "\n]}\n";
+    }
+
+    bool write_chrome_trace(const char* filename) const
+    {
+        std::ofstream file(filename);
+        write_chrome_trace(file);
+        return static_cast<bool>(file);
+    }
+
+  private:
+    // Nanoseconds written as exact microseconds with three decimals. Going through a double
+    // would round to six significant digits, which loses whole milliseconds after a few minutes.
+    struct Microseconds {
+        uint64_t ns;
+
+        friend std::ostream& operator<<(std::ostream& os, const Microseconds& time)
+        {
+            const auto fraction = time.ns % 1000;
+            return os << time.ns / 1000 << '.' << (fraction < 100 ? "0" : "")
+                      << (fraction < 10 ? "0" : "") << fraction;
+        }
+    };
+
+    std::vector<Event> _events;
+    size_t _next = 0;
+    size_t _size = 0;
+    uint64_t _frame = 0;
+    bool _enabled = false;
+    Clock::time_point _epoch = Clock::now();
+};
+
+// Times the enclosing scope on the CPU track. Does not read the clock while profiling is off.
+class ProfileScope {
+  public:
+    ProfileScope(Profiler& profiler, const char* name)
+        : _profiler(profiler), _name(name), _active(profiler.enabled()),
+          _start(_active ? profiler.now() : 0)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (_active) {
+            _profiler.record(_name, _start, _profiler.now() - _start, Profiler::Track::cpu,
+                             _profiler.frame());
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+  private:
+    Profiler& _profiler;
+    const char* _name;
+    bool _active;
+    uint64_t _start;
+};
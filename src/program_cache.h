@@ -0,0 +1,73 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+// Linked shader programs are cached as
+//
+//   ProgramCacheHeader
+//   the driver's program binary, binary_size bytes
+//
+// A binary only loads into the driver that produced it, so `key` hashes the driver's identity
+// strings along with the shader sources. Any mismatch means the program is compiled from source.
+constexpr char program_cache_magic[4] = {'R', 'C', 'P', 'B'};
+constexpr uint32_t program_cache_version = 1;
+
+struct ProgramCacheHeader {
+    char magic[4];
+    uint32_t version;
+    // The GLenum glGetProgramBinary reported the binary in
+    uint32_t binary_format;
+    uint32_t binary_size;
+    uint64_t key;
+};
+
+struct ProgramBinary {
+    uint32_t format = 0;
+    std::vector<char> bytes;
+};
+
+inline bool write_program_cache(const char* filename, uint64_t key, const ProgramBinary& binary)
+{
+    ProgramCacheHeader header;
+    std::memcpy(header.magic, program_cache_magic, sizeof(header.magic));
+    header.version = program_cache_version;
+    header.binary_format = binary.format;
+    header.binary_size = static_cast<uint32_t>(binary.bytes.size());
+    header.key = key;
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(binary.bytes.data(), 1, binary.bytes.size(), file) == binary.bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+// The cached binary, unless the file is missing, malformed or was written for another `key`.
+inline std::optional<ProgramBinary> read_program_cache(const char* filename, uint64_t key)
+{
+    const MappedFile file(filename);
+    ProgramCacheHeader header{};
+    if (file.size() < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, program_cache_magic, sizeof(header.magic)) != 0 ||
+        header.version != program_cache_version || header.key != key ||
+        header.binary_size == 0 || file.size() != sizeof(header) + header.binary_size) {
+        return std::nullopt;
+    }
+
+    ProgramBinary binary;
+    binary.format = header.binary_format;
+    binary.bytes.assign(file.data() + sizeof(header), file.data() + file.size());
+    return binary;
+}
@@ -0,0 +1,271 @@
+// Headless batch simulator: drives many independent trucks around a track faster than real time,
+// spread over every core, and reports their lap times. Handling parameters can be swept across
+// the trucks to compare them without a windowed run per sample.
+//
+//   rc_sim [--trucks N] [--laps N] [--max-seconds S] [--input SCRIPT] [--layout FILE]
+//          [--sweep NAME=MIN:MAX]... [--seed N] [--threads N] [--csv FILE]
+//
+// Without --input every truck is steered by autopilot() from truck_sim.h.
+#include "frame_report.h"
+#include "text_file.h"
+#include "thread_pool.h"
+#include "track.h"
+#include "track_field.h"
+#include "truck_sim.h"
+
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// The game runs two ticks per headless frame, so input scripts recorded for it count frames
+constexpr size_t ticks_per_script_frame = 2;
+
+struct Sweep {
+    float TruckParameters::*parameter;
+    float min;
+    float max;
+};
+
+struct SimOptions {
+    size_t trucks = 1000;
+    size_t laps = 3;
+    double max_seconds = 300;
+    std::string input_filename;
+    std::string layout_filename;
+    std::vector<Sweep> sweeps;
+    uint64_t seed = 1;
+    unsigned threads = 0; // 0 uses every core
+    std::string csv_filename;
+};
+
+// One truck and how it has done so far
+struct SimTruck {
+    TruckParameters parameters;
+    TruckState state;
+    RaceProgress progress;
+    size_t ticks = 0;
+    size_t lap_start_tick = 0;
+    std::vector<size_t> lap_ticks;
+};
+
+static void print_usage(const char* program)
+{
+    fprintf(stderr,
+            "Usage: %s [--trucks N] [--laps N] [--max-seconds S] [--input SCRIPT]\n"
+            "          [--layout FILE] [--sweep NAME=MIN:MAX]... [--seed N] [--threads N]\n"
+            "          [--csv FILE]\n"
+            "\n"
+            "  --trucks N          trucks to simulate, default 1000\n"
+            "  --laps N            laps each truck drives before it stops, default 3\n"
+            "  --max-seconds S     simulated time after which a truck gives up, default 300\n"
+            "  --input SCRIPT      drive every truck with a headless input script instead of\n"
+            "                      the autopilot\n"
+            "  --layout FILE       race on an ASCII track layout instead of the default one\n"
+            "  --sweep NAME=MIN:MAX  spread friction, max_power or acceleration uniformly\n"
+            "                      over [MIN, MAX] across the trucks, may be repeated\n"
+            "  --seed N            seed for the swept values, default 1\n"
+            "  --threads N         worker threads, default one per core\n"
+            "  --csv FILE          write one line per truck with its parameters and laps\n",
+            program);
+}
+
+static std::optional<Sweep> parse_sweep(const std::string& text)
+{
+    const auto equals = text.find('=');
+    const auto colon = text.find(':', equals);
+    if (equals == std::string::npos || colon == std::string::npos) {
+        return std::nullopt;
+    }
+    const auto name = text.substr(0, equals);
+    Sweep sweep{};
+    if (name == "friction") {
+        sweep.parameter = &TruckParameters::friction;
+    } else if (name == "max_power") {
+        sweep.parameter = &TruckParameters::max_power;
+    } else if (name == "acceleration") {
+        sweep.parameter = &TruckParameters::acceleration;
+    } else {
+        return std::nullopt;
+    }
+    sweep.min = std::stof(text.substr(equals + 1, colon - equals - 1));
+    sweep.max = std::stof(text.substr(colon + 1));
+    return sweep;
+}
+
+static SimOptions parse_options(int argc, char** argv)
+{
+    SimOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        try {
+            if (arg == "--trucks" && has_value) {
+                options.trucks = std::stoul(argv[++i]);
+            } else if (arg == "--laps" && has_value) {
+                options.laps = std::stoul(argv[++i]);
+            } else if (arg == "--max-seconds" && has_value) {
+                options.max_seconds = std::stod(argv[++i]);
+            } else if (arg == "--input" && has_value) {
+                options.input_filename = argv[++i];
+            } else if (arg == "--layout" && has_value) {
+                options.layout_filename = argv[++i];
+            } else if (arg == "--sweep" && has_value) {
+                const auto sweep = parse_sweep(argv[++i]);
+                if (!sweep) {
+                    fprintf(stderr, "Error: cannot sweep %s\n", argv[i]);
+                    exit(EXIT_FAILURE);
+                }
+                options.sweeps.push_back(*sweep);
+            } else if (arg == "--seed" && has_value) {
+                options.seed = std::stoull(argv[++i]);
+            } else if (arg == "--threads" && has_value) {
+                options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } else if (arg == "--csv" && has_value) {
+                options.csv_filename = argv[++i];
+            } else {
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        } catch (const std::exception&) {
+            fprintf(stderr, "Error: invalid value for %s\n", arg.c_str());
+            exit(EXIT_FAILURE);
+        }
+    }
+    return options;
+}
+
+// A uniform value in [0, 1) from the splitmix64 sequence, the same on every platform
+static float unit_random(uint64_t& state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return static_cast<float>(z >> 40) / static_cast<float>(1ull << 24);
+}
+
+int main(int argc, char** argv)
+{
+    const auto options = parse_options(argc, argv);
+
+    const auto layout_text = options.layout_filename.empty()
+                                 ? std::string(default_track_layout)
+                                 : load_text_from(options.layout_filename.c_str());
+    const auto track_layout = translate_track_layout(layout_text.c_str());
+    const TrackDistanceField track_field(track_layout);
+    const auto order = segment_order(track_layout);
+    const auto& start = track_layout.at(order[0]).centre;
+
+    std::optional<InputScript> script;
+    if (!options.input_filename.empty()) {
+        script.emplace(load_text_from(options.input_filename.c_str()));
+    }
+
+    std::vector<SimTruck> trucks(options.trucks);
+    for (size_t i = 0; i < trucks.size(); ++i) {
+        auto& truck = trucks[i];
+        truck.state.position = start;
+        truck.state.angle = glm::half_pi<float>();
+        uint64_t random = options.seed * 0x100000001b3ull + i;
+        for (const auto& sweep : options.sweeps) {
+            truck.parameters.*sweep.parameter =
+                sweep.min + (sweep.max - sweep.min) * unit_random(random);
+        }
+    }
+
+    const auto max_ticks = static_cast<size_t>(options.max_seconds / truck_tick_seconds);
+    const auto drive = [&](SimTruck& truck) {
+        while (truck.lap_ticks.size() < options.laps && truck.ticks < max_ticks) {
+            const auto input = script ? script->at(truck.ticks / ticks_per_script_frame)
+                                      : autopilot(truck.state, truck.progress, track_layout, order);
+            step_truck(truck.state, input, track_field, truck.parameters);
+            ++truck.ticks;
+            if (truck.progress.update(get_segment_coordinate(truck.state.position, track_layout),
+                                      order) &&
+                truck.progress.laps_completed(order.size()) > truck.lap_ticks.size()) {
+                truck.lap_ticks.push_back(truck.ticks - truck.lap_start_tick);
+                truck.lap_start_tick = truck.ticks;
+            }
+        }
+    };
+
+    std::optional<ThreadPool> own_pool;
+    if (options.threads > 0) {
+        own_pool.emplace(options.threads);
+    }
+    auto& pool = own_pool ? *own_pool : ThreadPool::shared();
+
+    // Trucks are handed out in blocks so each job is worth queueing
+    constexpr size_t block_size = 64;
+    const auto start_time = std::chrono::steady_clock::now();
+    pool.parallel_for((trucks.size() + block_size - 1) / block_size, [&](size_t block) {
+        const auto end = std::min(trucks.size(), (block + 1) * block_size);
+        for (size_t i = block * block_size; i < end; ++i) {
+            drive(trucks[i]);
+        }
+    });
+    const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start_time;
+
+    size_t total_ticks = 0;
+    size_t finished = 0;
+    std::vector<double> lap_seconds;
+    for (const auto& truck : trucks) {
+        total_ticks += truck.ticks;
+        finished += truck.lap_ticks.size() == options.laps ? 1u : 0u;
+        for (const auto ticks : truck.lap_ticks) {
+            lap_seconds.push_back(static_cast<double>(ticks) * truck_tick_seconds);
+        }
+    }
+    std::sort(lap_seconds.begin(), lap_seconds.end());
+    const auto lap_percentile = [&](double fraction) {
+        if (lap_seconds.empty()) {
+            return 0.0;
+        }
+        const auto last = static_cast<double>(lap_seconds.size() - 1);
+        return lap_seconds[static_cast<size_t>(fraction * last + 0.5)];
+    };
+
+    // One `name value` pair per line, like the game's frame report
+    std::cout << "trucks " << trucks.size() << "\n"
+              << "threads " << pool.size() << "\n"
+              << "trucks_finished " << finished << "\n"
+              << "laps " << lap_seconds.size() << "\n"
+              << "lap_seconds_best " << lap_percentile(0.0) << "\n"
+              << "lap_seconds_median " << lap_percentile(0.5) << "\n"
+              << "lap_seconds_worst " << lap_percentile(1.0) << "\n"
+              << "sim_ticks " << total_ticks << "\n"
+              << "wall_seconds " << wall_time.count() << "\n"
+              << "sim_ticks_per_second "
+              << static_cast<double>(total_ticks) / std::max(wall_time.count(), 1e-9) << "\n";
+
+    if (!options.csv_filename.empty()) {
+        std::ofstream csv(options.csv_filename);
+        csv << "truck,friction,max_power,acceleration,laps,best_lap_seconds,ticks\n";
+        for (size_t i = 0; i < trucks.size(); ++i) {
+            const auto& truck = trucks[i];
+            const auto best = std::min_element(truck.lap_ticks.begin(), truck.lap_ticks.end());
+            csv << i << "," << truck.parameters.friction << "," << truck.parameters.max_power
+                << "," << truck.parameters.acceleration << "," << truck.lap_ticks.size() << ","
+                << (best == truck.lap_ticks.end()
+                        ? 0.0
+                        : static_cast<double>(*best) * truck_tick_seconds)
+                << "," << truck.ticks << "\n";
+        }
+        if (!csv) {
+            fprintf(stderr, "Error: unable to write %s\n", options.csv_filename.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
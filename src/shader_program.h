@@ -0,0 +1,233 @@
+#pragma once
+
+#include "program_cache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// A vertex and fragment shader linked from source files. Linked programs are cached with
+// glGetProgramBinary where the driver supports it, so unchanged shaders skip compiling on later
+// launches, and reload_if_changed() relinks the program when either file is saved.
+//
+// Attributes are bound to fixed locations, the i-th name in `attributes` to location i, so a
+// vertex array set up for one link stays valid for every reload.
+class ShaderProgram {
+  public:
+    ShaderProgram(std::string vertex_filename, std::string fragment_filename,
+                  std::string cache_filename, std::vector<std::string> attributes)
+        : _vertex_filename(std::move(vertex_filename)),
+          _fragment_filename(std::move(fragment_filename)),
+          _cache_filename(std::move(cache_filename)), _attributes(std::move(attributes))
+    {
+        _vertex_time = modification_time(_vertex_filename);
+        _fragment_time = modification_time(_fragment_filename);
+        _program = load();
+    }
+
+    ~ShaderProgram()
+    {
+        if (_program) {
+            glDeleteProgram(_program);
+        }
+    }
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    bool is_valid() const { return _program != 0; }
+    GLuint id() const { return _program; }
+
+    // Relinks the program if a source file changed since it was last loaded, and returns whether
+    // it did. Uniform locations may move, so callers look them up again. A program that fails to
+    // compile is reported and the previous one kept, so a bad edit never blanks the screen.
+    bool reload_if_changed()
+    {
+        const auto vertex_time = modification_time(_vertex_filename);
+        const auto fragment_time = modification_time(_fragment_filename);
+        if (vertex_time == _vertex_time && fragment_time == _fragment_time) {
+            return false;
+        }
+        _vertex_time = vertex_time;
+        _fragment_time = fragment_time;
+
+        const auto program = load();
+        if (!program) {
+            return false;
+        }
+        glDeleteProgram(_program);
+        _program = program;
+        fprintf(stderr, "Reloaded %s and %s\n", _vertex_filename.c_str(),
+                _fragment_filename.c_str());
+        return true;
+    }
+
+  private:
+    using FileTime = std::filesystem::file_time_type;
+
+    static FileTime modification_time(const std::string& filename)
+    {
+        std::error_code error;
+        const auto time = std::filesystem::last_write_time(filename, error);
+        return error ? FileTime::min() : time;
+    }
+
+    static std::string read_text(const std::string& filename)
+    {
+        std::ifstream file(filename);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    static bool binaries_supported()
+    {
+        // Without GL 4.1 or ARB_get_program_binary the query fails and leaves the count at 0
+        GLint format_count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        while (glGetError() != GL_NO_ERROR) {
+        }
+        return format_count > 0;
+    }
+
+    // Identifies the driver and everything that goes into linking
+    uint64_t cache_key(const std::string& vertex_source, const std::string& fragment_source) const
+    {
+        const GLenum driver_strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+        std::string key;
+        for (const auto name : driver_strings) {
+            const auto* value = reinterpret_cast<const char*>(glGetString(name));
+            key += value ? value : "";
+            key += '\n';
+        }
+        for (const auto& attribute : _attributes) {
+            key += attribute + '\n';
+        }
+        key += vertex_source;
+        key += '\0';
+        key += fragment_source;
+        return fnv1a_64(key);
+    }
+
+    // Returns 0 after reporting the log if the shader does not compile
+    static GLuint compile(GLenum type, const std::string& source, const std::string& filename)
+    {
+        const GLuint shader = glCreateShader(type);
+        const char* text = source.c_str();
+        glShaderSource(shader, 1, &text, NULL);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (!compiled) {
+            GLint log_size = 0;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &log_size);
+            std::string log(static_cast<size_t>(std::max(log_size, 1)), '\0');
+            glGetShaderInfoLog(shader, log_size, NULL, log.data());
+            fprintf(stderr, "Error: unable to compile %s:\n%s\n", filename.c_str(), log.c_str());
+            glDeleteShader(shader);
+            return 0;
+        }
+        return shader;
+    }
+
+    static bool is_linked(GLuint program, const char* what)
+    {
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked && what) {
+            GLint log_size = 0;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &log_size);
+            std::string log(static_cast<size_t>(std::max(log_size, 1)), '\0');
+            glGetProgramInfoLog(program, log_size, NULL, log.data());
+            fprintf(stderr, "Error: unable to link %s:\n%s\n", what, log.c_str());
+        }
+        return linked == GL_TRUE;
+    }
+
+    // Links the current sources, from the program cache if it holds them
+    GLuint load() const
+    {
+        const auto vertex_source = read_text(_vertex_filename);
+        const auto fragment_source = read_text(_fragment_filename);
+        const bool use_cache = binaries_supported();
+        const auto key = use_cache ? cache_key(vertex_source, fragment_source) : 0;
+
+        if (use_cache) {
+            if (const auto binary = read_program_cache(_cache_filename.c_str(), key)) {
+                const GLuint program = glCreateProgram();
+                glProgramBinary(program, binary->format, binary->bytes.data(),
+                                static_cast<GLsizei>(binary->bytes.size()));
+                // A driver update can reject a binary even with a matching key
+                if (is_linked(program, NULL)) {
+                    return program;
+                }
+                glDeleteProgram(program);
+            }
+        }
+
+        const GLuint vertex_shader = compile(GL_VERTEX_SHADER, vertex_source, _vertex_filename);
+        const GLuint fragment_shader =
+            compile(GL_FRAGMENT_SHADER, fragment_source, _fragment_filename);
+        if (!vertex_shader || !fragment_shader) {
+            glDeleteShader(vertex_shader);
+            glDeleteShader(fragment_shader);
+            return 0;
+        }
+
+        const GLuint program = glCreateProgram();
+        glAttachShader(program, vertex_shader);
+        glAttachShader(program, fragment_shader);
+        for (size_t i = 0; i < _attributes.size(); ++i) {
+            glBindAttribLocation(program, static_cast<GLuint>(i), _attributes[i].c_str());
+        }
+        if (use_cache) {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+        glLinkProgram(program);
+        // Once linked, the program no longer needs its shaders
+        glDetachShader(program, vertex_shader);
+        glDetachShader(program, fragment_shader);
+        glDeleteShader(vertex_shader);
+        glDeleteShader(fragment_shader);
+
+        const auto what = _vertex_filename + " and " + _fragment_filename;
+        if (!is_linked(program, what.c_str())) {
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        if (use_cache) {
+            GLint binary_size = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+            ProgramBinary binary;
+            binary.bytes.resize(static_cast<size_t>(binary_size));
+            GLenum format = 0;
+            GLsizei written = 0;
+            if (binary_size > 0) {
+                glGetProgramBinary(program, binary_size, &written, &format, binary.bytes.data());
+            }
+            binary.bytes.resize(static_cast<size_t>(written));
+            binary.format = format;
+            if (!binary.bytes.empty() &&
+                !write_program_cache(_cache_filename.c_str(), key, binary)) {
+                fprintf(stderr, "Warning: unable to write %s\n", _cache_filename.c_str());
+            }
+        }
+        return program;
+    }
+
+    std::string _vertex_filename;
+    std::string _fragment_filename;
+    std::string _cache_filename;
+    std::vector<std::string> _attributes;
+    FileTime _vertex_time;
+    FileTime _fragment_time;
+    GLuint _program = 0;
+};
@@ -1,15 +1,27 @@
 #version 330
-uniform mat4 MVP;
-uniform mat4 ModelMatrix;
-in vec4 vPos;
+uniform mat4 ViewProjection;
+in vec3 vPos;
 in vec2 vTex;
 in vec3 vNorm;
 
+// Per instance: position on the ground plane, rotation about the up axis and uniform scale
+in vec2 iPosition;
+in float iAngle;
+in float iScale;
+
 out vec3 world_normal;
 out vec2 tex_coord;
 void main()
 {
-    gl_Position = MVP * vPos;
-    world_normal = mat3(ModelMatrix) * vNorm;
+    // Same transform as translate(iPosition.x, 0, iPosition.y) * rotate(iAngle, +Y)
+    float c = cos(iAngle);
+    float s = sin(iAngle);
+    mat4 model = mat4(c, 0, -s, 0,
+                      0, 1, 0, 0,
+                      s, 0, c, 0,
+                      iPosition.x, 0, iPosition.y, 1);
+
+    gl_Position = ViewProjection * model * vec4(vPos * iScale, 1.0);
+    world_normal = mat3(model) * vNorm;
     tex_coord = vTex;
 }
@@ -0,0 +1,402 @@
+#pragma once
+
+#include "model.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Sum of squared distances to a set of planes, as the symmetric 4x4 matrix of Garland and
+// Heckbert's "Surface Simplification Using Quadric Error Metrics". Only the upper triangle is
+// stored.
+struct Quadric {
+    double a[10] = {};
+
+    // Adds the plane n.x + d = 0, with unit normal n, scaled by `weight`.
+    void add_plane(const glm::vec3& n, float d, double weight)
+    {
+        const double x = n.x;
+        const double y = n.y;
+        const double z = n.z;
+        const double w = d;
+        const double terms[10] = {x * x, x * y, x * z, x * w, y * y,
+                                  y * z, y * w, z * z, z * w, w * w};
+        for (size_t i = 0; i < 10; ++i) {
+            a[i] += terms[i] * weight;
+        }
+    }
+
+    Quadric& operator+=(const Quadric& other)
+    {
+        for (size_t i = 0; i < 10; ++i) {
+            a[i] += other.a[i];
+        }
+        return *this;
+    }
+
+    double error(const glm::vec3& p) const
+    {
+        const double x = p.x;
+        const double y = p.y;
+        const double z = p.z;
+        return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x +
+               a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y + a[7] * z * z + 2 * a[8] * z +
+               a[9];
+    }
+};
+
+// Reduces `source` towards `target_triangle_count` triangles by repeatedly collapsing the edge
+// whose removal moves the surface least. Stops early once no edge can collapse without folding a
+// triangle over.
+//
+// Corners that share a position are collapsed together, but every corner keeps its own normal
+// and texture coordinate, so the palette colour of each surviving face is unchanged. Open edges
+// and edges between faces of different colours are weighted to stay in place, which keeps
+// silhouettes and colour borders from drifting.
+inline Model simplify_model(const ModelView& source, size_t target_triangle_count)
+{
+    // Weld corners into positions, since OBJ faces rarely share whole vertices
+    std::vector<uint32_t> position_of(source.vertex_count);
+    std::vector<glm::vec3> positions;
+    {
+        std::map<std::tuple<float, float, float>, uint32_t> welded;
+        for (size_t i = 0; i < source.vertex_count; ++i) {
+            const auto& p = source.vertices[i].pos;
+            const auto [it, inserted] =
+                welded.try_emplace({p.x, p.y, p.z}, static_cast<uint32_t>(positions.size()));
+            if (inserted) {
+                positions.push_back(p);
+            }
+            position_of[i] = it->second;
+        }
+    }
+
+    struct Triangle {
+        uint32_t corners[3];   // Into source.vertices
+        uint32_t positions[3]; // Into positions
+        bool alive;
+    };
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i + 2 < source.index_count; i += 3) {
+        Triangle triangle{};
+        triangle.alive = true;
+        for (size_t c = 0; c < 3; ++c) {
+            triangle.corners[c] = source.indices[i + c];
+            triangle.positions[c] = position_of[triangle.corners[c]];
+        }
+        const auto& p = triangle.positions;
+        if (p[0] != p[1] && p[1] != p[2] && p[2] != p[0]) {
+            triangles.push_back(triangle);
+        }
+    }
+
+    const auto face_normal = [&](const Triangle& triangle) {
+        const auto& p0 = positions[triangle.positions[0]];
+        return glm::cross(positions[triangle.positions[1]] - p0,
+                          positions[triangle.positions[2]] - p0);
+    };
+
+    // Every triangle's plane goes into the quadrics of its corners, weighted by its area
+    std::vector<Quadric> quadrics(positions.size());
+    std::vector<std::vector<uint32_t>> triangles_at(positions.size());
+    for (uint32_t t = 0; t < triangles.size(); ++t) {
+        const auto cross = face_normal(triangles[t]);
+        const auto area = glm::length(cross);
+        if (area > 0) {
+            const auto n = cross / area;
+            Quadric plane;
+            plane.add_plane(n, -glm::dot(n, positions[triangles[t].positions[0]]), area);
+            for (const auto p : triangles[t].positions) {
+                quadrics[p] += plane;
+            }
+        }
+        for (const auto p : triangles[t].positions) {
+            triangles_at[p].push_back(t);
+        }
+    }
+
+    // Open edges have one triangle, and colour borders have two that disagree on texture
+    // coordinates. Either gets a plane through the edge, perpendicular to its face.
+    {
+        constexpr double border_weight = 100.0;
+        std::map<std::pair<uint32_t, uint32_t>, std::vector<std::pair<uint32_t, uint32_t>>> edges;
+        for (uint32_t t = 0; t < triangles.size(); ++t) {
+            for (uint32_t c = 0; c < 3; ++c) {
+                const auto a = triangles[t].positions[c];
+                const auto b = triangles[t].positions[(c + 1) % 3];
+                edges[std::minmax(a, b)].emplace_back(t, c);
+            }
+        }
+        const auto tex_of = [&](uint32_t t, uint32_t p) {
+            for (uint32_t c = 0; c < 3; ++c) {
+                if (triangles[t].positions[c] == p) {
+                    const auto& tex = source.vertices[triangles[t].corners[c]].tex;
+                    return std::make_pair(tex[0], tex[1]);
+                }
+            }
+            return std::make_pair(uint16_t{0}, uint16_t{0});
+        };
+        for (const auto& [edge, sides] : edges) {
+            bool is_border = sides.size() != 2;
+            if (!is_border) {
+                const auto t0 = sides[0].first;
+                const auto t1 = sides[1].first;
+                is_border = tex_of(t0, edge.first) != tex_of(t1, edge.first) ||
+                            tex_of(t0, edge.second) != tex_of(t1, edge.second);
+            }
+            if (!is_border) {
+                continue;
+            }
+            const auto [t, c] = sides[0];
+            const auto& a = positions[triangles[t].positions[c]];
+            const auto& b = positions[triangles[t].positions[(c + 1) % 3]];
+            const auto along = b - a;
+            const auto perpendicular = glm::cross(along, face_normal(triangles[t]));
+            const auto length = glm::length(perpendicular);
+            if (length > 0) {
+                const auto n = perpendicular / length;
+                Quadric plane;
+                const auto weight = border_weight * static_cast<double>(glm::dot(along, along));
+                plane.add_plane(n, -glm::dot(n, a), weight);
+                quadrics[edge.first] += plane;
+                quadrics[edge.second] += plane;
+            }
+        }
+    }
+
+    // Candidate collapses, cheapest first. An entry is stale once either end has changed since
+    // it was pushed, which the version stamps detect.
+    struct Collapse {
+        double cost;
+        uint32_t keep;
+        uint32_t remove;
+        uint32_t keep_version;
+        uint32_t remove_version;
+        glm::vec3 target;
+
+        bool operator>(const Collapse& other) const
+        {
+            return std::tie(cost, keep, remove) > std::tie(other.cost, other.keep, other.remove);
+        }
+    };
+    std::vector<uint32_t> versions(positions.size(), 0);
+    std::vector<bool> removed(positions.size(), false);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    const auto push_collapse = [&](uint32_t a, uint32_t b) {
+        auto quadric = quadrics[a];
+        quadric += quadrics[b];
+        // Staying on an existing position keeps the silhouette made of original points
+        const glm::vec3 options[3] = {positions[a], positions[b],
+                                      (positions[a] + positions[b]) * 0.5f};
+        Collapse best{};
+        best.cost = -1;
+        for (const auto& option : options) {
+            const auto cost = std::max(quadric.error(option), 0.0);
+            if (best.cost < 0 || cost < best.cost) {
+                best.cost = cost;
+                best.target = option;
+            }
+        }
+        best.keep = std::min(a, b);
+        best.remove = std::max(a, b);
+        best.keep_version = versions[best.keep];
+        best.remove_version = versions[best.remove];
+        queue.push(best);
+    };
+
+    const auto neighbours_of = [&](uint32_t p) {
+        std::vector<uint32_t> result;
+        for (const auto t : triangles_at[p]) {
+            if (triangles[t].alive) {
+                for (const auto q : triangles[t].positions) {
+                    if (q != p) {
+                        result.push_back(q);
+                    }
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    };
+
+    for (uint32_t p = 0; p < positions.size(); ++p) {
+        for (const auto q : neighbours_of(p)) {
+            if (p < q) {
+                push_collapse(p, q);
+            }
+        }
+    }
+
+    // Moving `p` to `target` must not flip or flatten any triangle that survives the collapse
+    const auto folds_over = [&](uint32_t p, uint32_t other, const glm::vec3& target) {
+        for (const auto t : triangles_at[p]) {
+            const auto& triangle = triangles[t];
+            if (!triangle.alive || std::count(triangle.positions, triangle.positions + 3, other)) {
+                continue;
+            }
+            const auto before = face_normal(triangle);
+            const auto saved = positions[p];
+            positions[p] = target;
+            const auto after = face_normal(triangle);
+            positions[p] = saved;
+            if (glm::dot(before, after) <= 0.2f * glm::length(before) * glm::length(after)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    size_t triangle_count = triangles.size();
+    while (triangle_count > target_triangle_count && !queue.empty()) {
+        const auto collapse = queue.top();
+        queue.pop();
+        const auto keep = collapse.keep;
+        const auto remove = collapse.remove;
+        if (removed[keep] || removed[remove] || versions[keep] != collapse.keep_version ||
+            versions[remove] != collapse.remove_version) {
+            continue;
+        }
+
+        // Edges whose ends share more than two neighbours would pinch the surface
+        const auto keep_neighbours = neighbours_of(keep);
+        const auto remove_neighbours = neighbours_of(remove);
+        std::vector<uint32_t> shared;
+        std::set_intersection(keep_neighbours.begin(), keep_neighbours.end(),
+                              remove_neighbours.begin(), remove_neighbours.end(),
+                              std::back_inserter(shared));
+        if (shared.size() > 2 || folds_over(keep, remove, collapse.target) ||
+            folds_over(remove, keep, collapse.target)) {
+            continue;
+        }
+
+        positions[keep] = collapse.target;
+        quadrics[keep] += quadrics[remove];
+        removed[remove] = true;
+        ++versions[keep];
+        for (const auto t : triangles_at[remove]) {
+            auto& triangle = triangles[t];
+            if (!triangle.alive) {
+                continue;
+            }
+            for (auto& p : triangle.positions) {
+                if (p == remove) {
+                    p = keep;
+                }
+            }
+            const auto& p = triangle.positions;
+            if (p[0] == p[1] || p[1] == p[2] || p[2] == p[0]) {
+                triangle.alive = false;
+                --triangle_count;
+            } else {
+                triangles_at[keep].push_back(t);
+            }
+        }
+        triangles_at[remove].clear();
+
+        for (const auto q : neighbours_of(keep)) {
+            ++versions[q];
+        }
+        for (const auto q : neighbours_of(keep)) {
+            for (const auto r : neighbours_of(q)) {
+                push_collapse(q, r);
+            }
+        }
+    }
+
+    // Surviving corners keep their attributes and take the position they were collapsed into
+    Model result;
+    std::vector<uint32_t> remapped(source.vertex_count, UINT32_MAX);
+    for (const auto& triangle : triangles) {
+        if (!triangle.alive) {
+            continue;
+        }
+        for (size_t c = 0; c < 3; ++c) {
+            const auto corner = triangle.corners[c];
+            if (remapped[corner] == UINT32_MAX) {
+                remapped[corner] = static_cast<uint32_t>(result.vertices.size());
+                auto vertex = source.vertices[corner];
+                vertex.pos = positions[triangle.positions[c]];
+                result.vertices.push_back(vertex);
+            }
+            result.indices.push_back(remapped[corner]);
+        }
+    }
+    return result;
+}
+
+// Meshes are baked with this many levels of detail, level 0 being the mesh as authored and every
+// further level aiming for half the triangles of the one before.
+constexpr size_t lod_level_count = 4;
+
+// The name a simplified level is stored under, next to the original mesh
+inline std::string lod_name(const std::string& name, size_t level)
+{
+    return level == 0 ? name : name + "#lod" + std::to_string(level);
+}
+
+// Adds the simplified levels of every model to `models`.
+inline void add_lod_levels(std::map<std::string, Model>& models)
+{
+    std::vector<std::string> names;
+    for (const auto& model : models) {
+        names.push_back(model.first);
+    }
+    for (const auto& name : names) {
+        const auto triangle_count = models[name].indices.size() / 3;
+        for (size_t level = 1; level < lod_level_count; ++level) {
+            // Each level starts from the original, so errors do not compound
+            models[lod_name(name, level)] =
+                simplify_model(models[name].view(), triangle_count >> level);
+        }
+    }
+}
+
+// The level of detail for a mesh that appears `projected_pixels` tall on screen. Full detail is
+// kept down to `full_detail_pixels`, and each level after that takes over at half the size of
+// the one before, in step with its halved triangle count.
+inline size_t select_lod_level(float projected_pixels, float full_detail_pixels = 128.0f)
+{
+    size_t level = 0;
+    auto threshold = full_detail_pixels;
+    while (level + 1 < lod_level_count && projected_pixels < threshold) {
+        ++level;
+        threshold *= 0.5f;
+    }
+    return level;
+}
+
+// As above, for a mesh that was drawn at `current_level` last frame. It only moves to another
+// level once the mesh is `margin` times past the size where that level takes over, so a mesh
+// hovering around a threshold keeps its level instead of popping back and forth every frame.
+// A `current_level` of lod_level_count or more means the mesh has not been drawn yet.
+inline size_t select_lod_level(float projected_pixels, size_t current_level,
+                               float full_detail_pixels, float margin = 1.25f)
+{
+    if (current_level >= lod_level_count) {
+        return select_lod_level(projected_pixels, full_detail_pixels);
+    }
+    // Level `level` gives way to level + 1 below this many pixels
+    const auto threshold = [&](size_t level) {
+        return std::ldexp(full_detail_pixels, -static_cast<int>(level));
+    };
+    auto level = current_level;
+    while (level + 1 < lod_level_count && projected_pixels < threshold(level) / margin) {
+        ++level;
+    }
+    while (level > 0 && projected_pixels >= threshold(level - 1) * margin) {
+        --level;
+    }
+    return level;
+}
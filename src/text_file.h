@@ -0,0 +1,13 @@
+#pragma once
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// The whole of a text file, or an empty string if it cannot be read
+inline std::string load_text_from(const char* filename)
+{
+    std::ifstream t(filename);
+    std::string str((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
+    return str;
+}
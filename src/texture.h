@@ -0,0 +1,159 @@
+#pragma once
+
+#include "texture_cache.h"
+#include "thread_pool.h"
+
+#include <glad/glad.h>
+
+#include <png.h>
+
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Owns a GL texture name and deletes it when destroyed. An empty Texture has the name 0.
+class Texture {
+  public:
+    Texture() = default;
+    explicit Texture(GLuint name) : _name(name) {}
+    ~Texture() { reset(); }
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    Texture(Texture&& other) noexcept : _name(other._name) { other._name = 0; }
+
+    Texture& operator=(Texture&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            _name = other._name;
+            other._name = 0;
+        }
+        return *this;
+    }
+
+    GLuint name() const { return _name; }
+    explicit operator bool() const { return _name != 0; }
+
+    void reset()
+    {
+        if (_name) {
+            glDeleteTextures(1, &_name);
+            _name = 0;
+        }
+    }
+
+  private:
+    GLuint _name = 0;
+};
+
+// Decodes a PNG into RGBA8 pixels. libpng releases its own state when either step fails.
+inline std::optional<std::vector<uint8_t>> decode_png(const char* filename, uint32_t& width,
+                                                      uint32_t& height)
+{
+    png_image image;
+    std::memset(&image, 0, sizeof image);
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, filename)) {
+        fprintf(stderr, "Error: unable to read %s: %s\n", filename, image.message);
+        return std::nullopt;
+    }
+
+    image.format = PNG_FORMAT_RGBA;
+    std::vector<uint8_t> pixels(PNG_IMAGE_SIZE(image));
+    if (!png_image_finish_read(&image, NULL /*background*/, pixels.data(), 0 /*row_stride*/,
+                               NULL /*colormap*/)) {
+        fprintf(stderr, "Error: unable to decode %s: %s\n", filename, image.message);
+        return std::nullopt;
+    }
+    width = image.width;
+    height = image.height;
+    return pixels;
+}
+
+// Loads an image and its mip chain, from the .texcache sidecar when it matches the PNG, otherwise
+// by decoding the PNG and writing a fresh sidecar for the next run. Touches no GL state, so it can
+// run on any thread.
+inline std::optional<MipmappedImage> load_texture_image(const char* filename)
+{
+    const auto cache_filename = texture_cache_filename(filename);
+    const auto source_hash = hash_file(filename);
+    if (!source_hash) {
+        fprintf(stderr, "Error: unable to open %s\n", filename);
+        return std::nullopt;
+    }
+
+    MipmappedImage image;
+    if (read_texture_cache(cache_filename.c_str(), *source_hash, image)) {
+        return image;
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    const auto pixels = decode_png(filename, width, height);
+    if (!pixels) {
+        return std::nullopt;
+    }
+    image = build_mip_chain(width, height, *pixels);
+    if (!write_texture_cache(cache_filename.c_str(), *source_hash, image)) {
+        fprintf(stderr, "Warning: unable to write %s\n", cache_filename.c_str());
+    }
+    return image;
+}
+
+// Starts loading an image on the shared thread pool. Hand the result to upload_texture() on the
+// thread that owns the GL context.
+inline std::future<std::optional<MipmappedImage>> load_texture_image_async(std::string filename)
+{
+    return ThreadPool::shared().submit(
+        [filename = std::move(filename)] { return load_texture_image(filename.c_str()); });
+}
+
+// Creates a mipmapped texture from every level of `image`. The pixels are staged in a
+// pixel buffer object, so the driver can copy them to the texture without another trip through
+// client memory.
+inline Texture upload_texture(const MipmappedImage& image)
+{
+    GLuint staging_buffer = 0;
+    glGenBuffers(1, &staging_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging_buffer);
+    const auto size = static_cast<GLsizeiptr>(image.pixels.size());
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!staging) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &staging_buffer);
+        return Texture();
+    }
+    std::memcpy(staging, image.pixels.data(), image.pixels.size());
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    GLuint name = 0;
+    glGenTextures(1, &name);
+    Texture texture(name);
+    glBindTexture(GL_TEXTURE_2D, name);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        const auto& level = image.levels[i];
+        // With a buffer bound, the pointer argument is an offset into it
+        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), GL_RGBA8,
+                     static_cast<GLsizei>(level.width), static_cast<GLsizei>(level.height), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(level.offset));
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                    static_cast<GLint>(image.levels.size()) - 1);
+    // Texels stay sharp up close, and blend between mip levels as they shrink
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // The texture keeps its own copy, so the staging buffer can go as soon as the copy is queued
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &staging_buffer);
+    return texture;
+}
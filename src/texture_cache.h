@@ -0,0 +1,174 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// An RGBA8 image and its whole mip chain, stored back to back from level 0 down to 1x1.
+struct MipmappedImage {
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        size_t offset; // Into pixels
+    };
+
+    std::vector<Level> levels;
+    std::vector<uint8_t> pixels;
+
+    size_t level_size(size_t level) const
+    {
+        return size_t{4} * levels[level].width * levels[level].height;
+    }
+};
+
+// Builds every mip level below `level0` (`width` x `height` RGBA8 pixels) with a 2x2 box filter.
+// Odd sized levels repeat their last row or column.
+inline MipmappedImage build_mip_chain(uint32_t width, uint32_t height,
+                                      const std::vector<uint8_t>& level0)
+{
+    MipmappedImage image;
+    image.levels.push_back({width, height, 0});
+    image.pixels = level0;
+    image.pixels.resize(size_t{4} * width * height);
+
+    while (width > 1 || height > 1) {
+        const auto& source_level = image.levels.back();
+        const auto source_offset = source_level.offset;
+        const auto source_width = source_level.width;
+        const auto source_height = source_level.height;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+
+        const auto offset = image.pixels.size();
+        image.levels.push_back({width, height, offset});
+        image.pixels.resize(offset + size_t{4} * width * height);
+
+        const auto texel = [&](uint32_t x, uint32_t y, uint32_t channel) {
+            x = std::min(x, source_width - 1);
+            y = std::min(y, source_height - 1);
+            return static_cast<uint32_t>(
+                image.pixels[source_offset + (size_t{y} * source_width + x) * 4 + channel]);
+        };
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                for (uint32_t channel = 0; channel < 4; ++channel) {
+                    const auto sum = texel(2 * x, 2 * y, channel) +
+                                     texel(2 * x + 1, 2 * y, channel) +
+                                     texel(2 * x, 2 * y + 1, channel) +
+                                     texel(2 * x + 1, 2 * y + 1, channel);
+                    image.pixels[offset + (size_t{y} * width + x) * 4 + channel] =
+                        static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+    return image;
+}
+
+// Decoded textures are cached next to their PNG as
+//
+//   TextureCacheHeader
+//   TextureCacheLevel[level_count]
+//   pixels of every level, level 0 first
+//
+// The pixels are stored uncompressed, exactly as they are uploaded, so a cache hit costs a
+// mapping and a copy rather than a PNG decode. Offsets are from the start of the file.
+constexpr char texture_cache_magic[4] = {'R', 'C', 'T', 'X'};
+constexpr uint32_t texture_cache_version = 1;
+// Larger levels than any GPU samples from are taken as a corrupt cache
+constexpr uint32_t texture_cache_max_size = 16384;
+
+struct TextureCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t level_count;
+    uint32_t reserved;
+    // FNV-1a hash of the image file the cache was decoded from.
+    uint64_t source_hash;
+};
+
+struct TextureCacheLevel {
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;
+};
+
+inline std::string texture_cache_filename(const char* image_filename)
+{
+    return std::string(image_filename) + ".texcache";
+}
+
+inline bool write_texture_cache(const char* filename, uint64_t source_hash,
+                                const MipmappedImage& image)
+{
+    const auto pixels_offset =
+        sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * image.levels.size();
+
+    TextureCacheHeader header;
+    std::memcpy(header.magic, texture_cache_magic, sizeof(header.magic));
+    header.version = texture_cache_version;
+    header.level_count = static_cast<uint32_t>(image.levels.size());
+    header.reserved = 0;
+    header.source_hash = source_hash;
+
+    std::vector<TextureCacheLevel> levels;
+    for (const auto& level : image.levels) {
+        levels.push_back({level.width, level.height, pixels_offset + level.offset});
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(levels.data(), sizeof(TextureCacheLevel), levels.size(), file) == levels.size() &&
+        fwrite(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+    return fclose(file) == 0 && written;
+}
+
+// Loads a texture cache back into a MipmappedImage. Fails if the file is missing, malformed,
+// from another format version, or was decoded from a different source than `source_hash`.
+inline bool read_texture_cache(const char* filename, uint64_t source_hash, MipmappedImage& image)
+{
+    const MappedFile file(filename);
+    TextureCacheHeader header{};
+    if (file.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, texture_cache_magic, sizeof(header.magic)) != 0 ||
+        header.version != texture_cache_version || header.source_hash != source_hash ||
+        header.level_count == 0 ||
+        file.size() < sizeof(header) + sizeof(TextureCacheLevel) * header.level_count) {
+        return false;
+    }
+
+    std::vector<TextureCacheLevel> levels(header.level_count);
+    std::memcpy(levels.data(), file.data() + sizeof(header),
+                sizeof(TextureCacheLevel) * levels.size());
+    const auto pixels_offset = sizeof(header) + sizeof(TextureCacheLevel) * levels.size();
+
+    MipmappedImage result;
+    for (const auto& level : levels) {
+        if (level.width == 0 || level.height == 0 || level.width > texture_cache_max_size ||
+            level.height > texture_cache_max_size) {
+            return false;
+        }
+        const auto size = uint64_t{4} * level.width * level.height;
+        if (level.offset < pixels_offset || level.offset > file.size() ||
+            size > file.size() - level.offset) {
+            return false;
+        }
+        result.levels.push_back(
+            {level.width, level.height, static_cast<size_t>(level.offset - pixels_offset)});
+    }
+    result.pixels.assign(file.data() + pixels_offset, file.data() + file.size());
+    image = std::move(result);
+    return true;
+}
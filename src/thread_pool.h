@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads fed from a single job queue.
+class ThreadPool {
+  public:
+    explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency())
+    {
+        thread_count = std::max(1u, thread_count);
+        _workers.reserve(thread_count);
+        for (unsigned i = 0; i < thread_count; ++i) {
+            _workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _job_available.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return _workers.size(); }
+
+    // Runs fn(i) for every i in [0, count) and blocks until all of them have returned. The calling
+    // thread takes indices too, but only this call's: it never picks up unrelated queued jobs
+    // while it waits, and since it can finish every index by itself, nested calls cannot
+    // deadlock the pool.
+    template <typename F> void parallel_for(size_t count, F&& fn)
+    {
+        parallel_for_ranges(count, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                fn(i);
+            }
+        });
+    }
+
+    // Runs fn(begin, end) over consecutive ranges of at most `grain` indices that cover
+    // [0, count), and blocks until all of them have returned. Rather than a job per range, one
+    // helper job per worker claims ranges from a shared counter until none are left, so whichever
+    // threads are free take over the ranges the busy ones have not reached. That keeps the cost
+    // to a few locks however many ranges there are, for loops that run every tick. The calling
+    // thread claims ranges too, and never waits on a helper that has not started.
+    template <typename F> void parallel_for_ranges(size_t count, size_t grain, F&& fn)
+    {
+        grain = std::max(grain, size_t{1});
+        const size_t range_count = (count + grain - 1) / grain;
+        if (range_count <= 1) {
+            if (count > 0) {
+                fn(size_t{0}, count);
+            }
+            return;
+        }
+
+        // Helpers that start after the last range has finished only touch this, never `fn`
+        struct Ranges {
+            size_t count;
+            size_t grain;
+            size_t range_count;
+            std::remove_reference_t<F>* fn;
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> remaining;
+            std::mutex done_mutex;
+            std::condition_variable done;
+        };
+        auto ranges = std::make_shared<Ranges>();
+        ranges->count = count;
+        ranges->grain = grain;
+        ranges->range_count = range_count;
+        ranges->fn = std::addressof(fn);
+        ranges->remaining = range_count;
+
+        const auto claim_ranges = [](Ranges& shared) {
+            for (;;) {
+                const auto range = shared.next.fetch_add(1);
+                if (range >= shared.range_count) {
+                    return;
+                }
+                const auto begin = range * shared.grain;
+                (*shared.fn)(begin, std::min(begin + shared.grain, shared.count));
+                if (shared.remaining.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> done_lock(shared.done_mutex);
+                    shared.done.notify_all();
+                }
+            }
+        };
+
+        const auto helper_count = std::min(_workers.size(), range_count - 1);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (size_t i = 0; i < helper_count; ++i) {
+                _jobs.emplace_back([ranges, claim_ranges] { claim_ranges(*ranges); });
+            }
+        }
+        _job_available.notify_all();
+
+        claim_ranges(*ranges);
+        std::unique_lock<std::mutex> done_lock(ranges->done_mutex);
+        ranges->done.wait(done_lock, [&] { return ranges->remaining == 0; });
+    }
+
+    // Queues fn() to run on a worker and returns immediately. The result, or the exception fn
+    // threw, is delivered through the returned future.
+    template <typename F>
+    auto submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        // std::function needs a copyable job, and packaged_task is move-only
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(fn));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.emplace_back([task] { (*task)(); });
+        }
+        _job_available.notify_one();
+        return result;
+    }
+
+    // Process-wide pool sized to the machine.
+    static ThreadPool& shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+  private:
+    void worker_loop()
+    {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _job_available.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+                if (_jobs.empty()) {
+                    return;
+                }
+                job = std::move(_jobs.front());
+                _jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _job_available;
+    bool _stopping = false;
+};
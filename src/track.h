@@ -0,0 +1,253 @@
+#pragma once
+
+#include "load_obj.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Every tile of a layout is a square this many units across
+constexpr float track_tile_size = 60.0f;
+// Curves are quarter circles of this radius about a corner of their tile
+constexpr float track_curve_radius = track_tile_size / 2.0f;
+
+// What a tile of the layout holds. Grass is zero, so a default tile is off the track.
+enum class SegmentType : uint8_t {
+    grass,
+    starting_line,
+    horizontal,
+    vertical,
+    top_left,
+    top_right,
+    bottom_right,
+    bottom_left,
+};
+constexpr size_t segment_type_count = 8;
+
+// Which way a truck drives across the layout, in rows and columns
+enum class Heading : uint8_t { up, right, down, left };
+
+enum class SegmentShape : uint8_t { none, straight, curve };
+
+// Everything that depends only on a tile's type
+struct SegmentTraits {
+    char ascii;            // How layouts write it
+    const char* mesh_name; // Its mesh in track_segments.obj
+    SegmentShape shape;
+    // Straights: the unit vector across the track, as (x, z)
+    float across_x;
+    float across_z;
+    // Curves: the centre of the arc, relative to the centre of the tile
+    float pivot_x;
+    float pivot_z;
+    // The heading a truck leaves with, for each heading it enters with
+    Heading turns[4];
+};
+
+// Indexed by SegmentType. A layout writes `s` for the starting line, `-` and `|` for straights,
+// `r`, `;`, `l` and `j` for the corners they look like, and a space for grass.
+constexpr SegmentTraits segment_traits[segment_type_count] = {
+    {' ', "", SegmentShape::none, 0, 0, 0, 0,
+     {Heading::up, Heading::right, Heading::down, Heading::left}},
+    {'s', "Starting_Line", SegmentShape::straight, 0, 1, 0, 0,
+     {Heading::up, Heading::right, Heading::down, Heading::left}},
+    {'-', "Horizontal", SegmentShape::straight, 0, 1, 0, 0,
+     {Heading::up, Heading::right, Heading::down, Heading::left}},
+    {'|', "Vertical", SegmentShape::straight, 1, 0, 0, 0,
+     {Heading::up, Heading::right, Heading::down, Heading::left}},
+    {'r', "Top_Left", SegmentShape::curve, 0, 0, track_curve_radius, track_curve_radius,
+     {Heading::right, Heading::right, Heading::down, Heading::down}},
+    {';', "Top_Right", SegmentShape::curve, 0, 0, -track_curve_radius, track_curve_radius,
+     {Heading::left, Heading::down, Heading::down, Heading::left}},
+    {'j', "Bottom_Right", SegmentShape::curve, 0, 0, -track_curve_radius, -track_curve_radius,
+     {Heading::up, Heading::up, Heading::left, Heading::left}},
+    {'l', "Bottom_Left", SegmentShape::curve, 0, 0, track_curve_radius, -track_curve_radius,
+     {Heading::up, Heading::right, Heading::right, Heading::up}},
+};
+
+constexpr const SegmentTraits& traits_of(SegmentType type)
+{
+    return segment_traits[static_cast<size_t>(type)];
+}
+
+// The type a layout character stands for. Anything unrecognised is grass.
+constexpr SegmentType segment_type_from_ascii(char c)
+{
+    for (size_t i = 1; i < segment_type_count; ++i) {
+        if (segment_traits[i].ascii == c) {
+            return static_cast<SegmentType>(i);
+        }
+    }
+    return SegmentType::grass;
+}
+
+// The layout the game races on unless told otherwise
+constexpr const char* default_track_layout = "   r;\n"
+                                             "r-;||\n"
+                                             "| lj|\n"
+                                             "l-s-j\n";
+
+// One tile of a track layout, with what the per-tick checks need worked out when it is loaded
+struct TrackTile {
+    SegmentType type = SegmentType::grass;
+    // The centre of the tile on the ground plane, as (x, z)
+    glm::vec2 centre{0};
+    // The centre of a curve's arc, or the centre of the tile for any other type
+    glm::vec2 pivot{0};
+};
+
+// The tiles of a layout, stored row after row in one array
+class TrackLayout {
+  public:
+    TrackLayout(size_t rows, size_t columns)
+        : _rows(rows), _columns(columns), _tiles(rows * columns)
+    {
+    }
+
+    size_t rows() const { return _rows; }
+    size_t columns() const { return _columns; }
+    const std::vector<TrackTile>& tiles() const { return _tiles; }
+
+    TrackTile& at(size_t row, size_t column) { return _tiles[row * _columns + column]; }
+    const TrackTile& at(size_t row, size_t column) const { return _tiles[row * _columns + column]; }
+    const TrackTile& at(const std::pair<size_t, size_t>& coordinate) const
+    {
+        return at(coordinate.first, coordinate.second);
+    }
+
+  private:
+    size_t _rows;
+    size_t _columns;
+    std::vector<TrackTile> _tiles;
+};
+
+// Parses an ASCII layout, one row per line. Segment names are resolved here, once, so nothing
+// that runs per tick looks at a string.
+inline TrackLayout translate_track_layout(const char* track_layout)
+{
+    const auto layout_rows = ObjFile::split(track_layout, '\n');
+    TrackLayout result(layout_rows.size(), layout_rows[0].length());
+
+    size_t y = 0;
+    for (const auto& row_text : layout_rows) {
+        size_t x = 0;
+        for (const char c : row_text) {
+            if (x >= result.columns()) {
+                break;
+            }
+            auto& tile = result.at(y, x);
+            tile.type = segment_type_from_ascii(c);
+            tile.centre = {static_cast<float>(x) * track_tile_size,
+                           static_cast<float>(y) * track_tile_size};
+            const auto& traits = traits_of(tile.type);
+            tile.pivot = tile.centre + glm::vec2{traits.pivot_x, traits.pivot_z};
+            ++x;
+        }
+        ++y;
+    }
+    return result;
+}
+
+// Return a list of coordinates within the track_layout defining the path
+// through the track.
+inline std::vector<std::pair<size_t, size_t>> segment_order(const TrackLayout& track_layout)
+{
+    struct Offset {
+        int dRow;
+        int dCol;
+    };
+    size_t startingRow = 0;
+    size_t startingCol = 0;
+
+    // Also gotta make sure there's only ONE starting line.
+    for (; startingRow < track_layout.rows(); ++startingRow) {
+        bool found = false;
+        for (startingCol = 0; startingCol < track_layout.columns(); ++startingCol) {
+            if (track_layout.at(startingRow, startingCol).type == SegmentType::starting_line) {
+                found = true;
+                break;
+            }
+        }
+        if (found)
+            break;
+    }
+
+    // Indexed by Heading
+    static const Offset offsets[] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
+    Heading current_direction = Heading::left;
+    std::vector<std::pair<size_t, size_t>> result{{startingRow, startingCol}};
+
+    int row = static_cast<int>(startingRow) + offsets[static_cast<size_t>(current_direction)].dRow;
+    int col = static_cast<int>(startingCol) + offsets[static_cast<size_t>(current_direction)].dCol;
+    while (!(row == static_cast<int>(startingRow) && col == static_cast<int>(startingCol))) {
+        result.push_back({row, col});
+        const auto type = track_layout.at(static_cast<size_t>(row), static_cast<size_t>(col)).type;
+        // Turn on curves
+        current_direction = traits_of(type).turns[static_cast<size_t>(current_direction)];
+        row += offsets[static_cast<size_t>(current_direction)].dRow;
+        col += offsets[static_cast<size_t>(current_direction)].dCol;
+    }
+
+    return result;
+}
+
+inline glm::vec2 locate_start_position(const char* track_layout)
+{
+    glm::vec2 result{0};
+    float y_offset = 0;
+    for (const auto& row_text : ObjFile::split(track_layout, '\n')) {
+        float x_offset = 0;
+        for (const char c : row_text) {
+            if (c == 's') {
+                result = glm::vec2{x_offset, y_offset};
+                return result;
+            }
+            x_offset += track_tile_size;
+        }
+        y_offset += track_tile_size;
+    }
+    return result;
+}
+
+// The row and column of the tile under `point`, or the largest size_t for both off the layout
+inline std::pair<size_t, size_t> get_segment_coordinate(const glm::vec2& point,
+                                                        const TrackLayout& track_layout)
+{
+    const auto x = std::floor((point.x + track_tile_size / 2.0f) / track_tile_size);
+    const auto y = std::floor((point.y + track_tile_size / 2.0f) / track_tile_size);
+
+    if (x < 0 || y < 0 || y >= static_cast<float>(track_layout.rows()) ||
+        x >= static_cast<float>(track_layout.columns()))
+        return {std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max()};
+
+    return {static_cast<size_t>(y), static_cast<size_t>(x)};
+}
+
+// Follows one truck around a track's segment order. A segment only counts when it is the next one
+// along, so cutting across the infield earns nothing.
+struct RaceProgress {
+    size_t segments_reached = 0;
+
+    // Advances if `coordinate` is the next segment along `order`, and returns whether it did.
+    bool update(const std::pair<size_t, size_t>& coordinate,
+                const std::vector<std::pair<size_t, size_t>>& order)
+    {
+        if (coordinate != order[(segments_reached + 1) % order.size()]) {
+            return false;
+        }
+        ++segments_reached;
+        return true;
+    }
+
+    // A lap is complete once the truck has come back round to the segment after the start
+    size_t laps_completed(size_t segment_count) const
+    {
+        return segments_reached == 0 ? 0 : (segments_reached - 1) / segment_count;
+    }
+};
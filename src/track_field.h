@@ -0,0 +1,181 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "track.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Trucks drive within this distance of the middle of the track
+constexpr float track_half_width = 9.0f;
+
+// The point on the middle line of `tile`'s track nearest to `point`. Straights run through the
+// middle of their tile from edge to edge, and curves are a quarter circle between the middles of
+// two edges. `tile` must not be grass.
+inline glm::vec2 nearest_middle_point(const glm::vec2& point, const TrackTile& tile)
+{
+    const auto& traits = traits_of(tile.type);
+    if (traits.shape == SegmentShape::straight) {
+        const glm::vec2 along{traits.across_z, traits.across_x};
+        const auto t = std::clamp(glm::dot(point - tile.centre, along), -track_tile_size / 2.0f,
+                                  track_tile_size / 2.0f);
+        return tile.centre + along * t;
+    }
+
+    // The arc sweeps the quarter of the circle facing the tile's centre
+    const auto inwards = glm::sign(tile.centre - tile.pivot);
+    const auto from_pivot = point - tile.pivot;
+    const auto length = glm::length(from_pivot);
+    if (from_pivot.x * inwards.x >= 0 && from_pivot.y * inwards.y >= 0) {
+        return length > 0 ? tile.pivot + from_pivot * (track_curve_radius / length)
+                          : tile.pivot + glm::vec2{inwards.x * track_curve_radius, 0};
+    }
+    const auto end_x = tile.pivot + glm::vec2{inwards.x * track_curve_radius, 0};
+    const auto end_z = tile.pivot + glm::vec2{0, inwards.y * track_curve_radius};
+    return glm::length(point - end_x) <= glm::length(point - end_z) ? end_x : end_z;
+}
+
+// The signed distance from the edge of the track, and its gradient, baked on a grid over the whole
+// layout. Every containment, clamping and distance query is one bilinear lookup, however the
+// tiles join, and they all agree on the track's width.
+//
+// Samples sit on the corners of square cells, `samples_per_tile` to a tile side, starting at the
+// top left corner of the layout. Only distances are stored, four bytes a sample, and gradients
+// come from their slope. The default puts samples 6 units apart, which keeps the edges within a
+// quarter of a unit of exact while a 200x200 tile layout stays at 16 MB. Distances are exact at
+// the samples out to a tile beyond the middle line, which covers everything near the track; past
+// that they level off. Outside the layout the distance grows by how far the point is beyond its
+// border.
+class TrackDistanceField {
+  public:
+    explicit TrackDistanceField(const TrackLayout& track_layout, size_t samples_per_tile = 10)
+        : _columns(track_layout.columns() * samples_per_tile + 1),
+          _rows(track_layout.rows() * samples_per_tile + 1),
+          _cell_size(track_tile_size / static_cast<float>(samples_per_tile)),
+          _inverse_cell_size(static_cast<float>(samples_per_tile) / track_tile_size),
+          _origin(-track_tile_size / 2.0f), _distances(_columns * _rows)
+    {
+        ThreadPool::shared().parallel_for(_rows, [&](size_t row) {
+            for (size_t column = 0; column < _columns; ++column) {
+                bake(track_layout, row, column);
+            }
+        });
+    }
+
+    // Samples across and down the grid
+    size_t columns() const { return _columns; }
+    size_t rows() const { return _rows; }
+    float cell_size() const { return _cell_size; }
+    float inverse_cell_size() const { return _inverse_cell_size; }
+    const glm::vec2& origin() const { return _origin; }
+    const float* distances() const { return _distances.data(); }
+
+    // How far `point` is outside the edge of the track, negative on the track
+    float distance(const glm::vec2& point) const
+    {
+        const auto cell = locate(point);
+        const auto* d = &_distances[cell.index];
+        const auto top = d[0] + (d[1] - d[0]) * cell.fx;
+        const auto bottom = d[_columns] + (d[_columns + 1] - d[_columns]) * cell.fx;
+        return top + (bottom - top) * cell.fy + cell.outside;
+    }
+
+    // The direction in which distance() grows fastest, a unit vector pointing away from the middle
+    // of the track, or zero where it has no clear direction
+    glm::vec2 gradient(const glm::vec2& point) const
+    {
+        // The slope of the bilinear surface that distance() reads, in distance per cell
+        const auto cell = locate(point);
+        const auto* d = &_distances[cell.index];
+        const auto top = d[1] - d[0];
+        const auto bottom = d[_columns + 1] - d[_columns];
+        const auto left = d[_columns] - d[0];
+        const auto right = d[_columns + 1] - d[1];
+        const glm::vec2 slope{top + (bottom - top) * cell.fy, left + (right - left) * cell.fx};
+        const auto length = glm::length(slope);
+        return length > 1e-6f ? slope / length : glm::vec2{0};
+    }
+
+    // Whether `point` is on the track, or within `margin` of its edge
+    bool is_on_track(const glm::vec2& point, float margin = 0) const
+    {
+        return distance(point) <= margin;
+    }
+
+    // Pulls `point` back onto the track if it has left it
+    void clamp(glm::vec2& point) const
+    {
+        const auto outside = distance(point);
+        if (outside > 0) {
+            point -= gradient(point) * outside;
+        }
+    }
+
+  private:
+    struct Cell {
+        size_t index; // Of the sample at the cell's top left corner
+        float fx;
+        float fy;
+        float outside; // Distance beyond the border of the layout
+    };
+
+    // TrackQuery repeats these steps lane by lane, so each point gets the same answer either way
+    Cell locate(const glm::vec2& point) const
+    {
+        const auto u = (point.x - _origin.x) * _inverse_cell_size;
+        const auto v = (point.y - _origin.y) * _inverse_cell_size;
+        const auto max_u = static_cast<float>(_columns - 1);
+        const auto max_v = static_cast<float>(_rows - 1);
+        // Written so that NaN lands on 0
+        const auto cu = u > 0 ? (u < max_u ? u : max_u) : 0.0f;
+        const auto cv = v > 0 ? (v < max_v ? v : max_v) : 0.0f;
+        const auto ex = (u - cu) * _cell_size;
+        const auto ey = (v - cv) * _cell_size;
+        const auto column = std::min(static_cast<size_t>(cu), _columns - 2);
+        const auto row = std::min(static_cast<size_t>(cv), _rows - 2);
+        return {row * _columns + column, cu - static_cast<float>(column),
+                cv - static_cast<float>(row), std::sqrt(ex * ex + ey * ey)};
+    }
+
+    void bake(const TrackLayout& track_layout, size_t row, size_t column)
+    {
+        const glm::vec2 point = _origin + glm::vec2{static_cast<float>(column) * _cell_size,
+                                                    static_cast<float>(row) * _cell_size};
+        // Middle lines never leave their tile, so only the tiles around the point can be nearest
+        const auto tile_x = static_cast<long>(
+            std::floor((point.x + track_tile_size / 2.0f) / track_tile_size));
+        const auto tile_y = static_cast<long>(
+            std::floor((point.y + track_tile_size / 2.0f) / track_tile_size));
+
+        auto nearest_distance = track_tile_size;
+        for (long y = tile_y - 1; y <= tile_y + 1; ++y) {
+            for (long x = tile_x - 1; x <= tile_x + 1; ++x) {
+                if (x < 0 || y < 0 || static_cast<size_t>(x) >= track_layout.columns() ||
+                    static_cast<size_t>(y) >= track_layout.rows()) {
+                    continue;
+                }
+                const auto& tile =
+                    track_layout.at(static_cast<size_t>(y), static_cast<size_t>(x));
+                if (tile.type == SegmentType::grass) {
+                    continue;
+                }
+                nearest_distance = std::min(
+                    nearest_distance, glm::length(point - nearest_middle_point(point, tile)));
+            }
+        }
+
+        _distances[row * _columns + column] = nearest_distance - track_half_width;
+    }
+
+    size_t _columns;
+    size_t _rows;
+    float _cell_size;
+    float _inverse_cell_size;
+    glm::vec2 _origin;
+    std::vector<float> _distances;
+};
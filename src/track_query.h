@@ -0,0 +1,207 @@
+#pragma once
+
+#include "track_field.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(__x86_64__) || defined(_M_X64)
+#define RC_TRACK_QUERY_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled in with a target attribute and only used when the CPU reports it, so the
+// rest of the program keeps its baseline instruction set
+#if defined(RC_TRACK_QUERY_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define RC_TRACK_QUERY_AVX2 1
+#define RC_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(RC_TRACK_QUERY_SSE2) && defined(__AVX2__)
+#define RC_TRACK_QUERY_AVX2 1
+#define RC_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+// Answers TrackDistanceField::is_on_track for whole arrays of points at a time, for scattering
+// props and checking every vehicle each tick.
+//
+// Each point is a bilinear lookup in the field's distances. The vector paths repeat the field's
+// own steps lane by lane, rounding included, so every path agrees with it point for point.
+class TrackQuery {
+  public:
+    enum class Path { scalar, sse2, avx2 };
+
+    explicit TrackQuery(const TrackDistanceField& field) : _field(field) {}
+
+    // The fastest path this CPU supports
+    static Path best_path()
+    {
+#if defined(RC_TRACK_QUERY_AVX2) && (defined(__GNUC__) || defined(__clang__))
+        static const bool has_avx2 = __builtin_cpu_supports("avx2");
+        return has_avx2 ? Path::avx2 : Path::sse2;
+#elif defined(RC_TRACK_QUERY_AVX2)
+        return Path::avx2;
+#elif defined(RC_TRACK_QUERY_SSE2)
+        return Path::sse2;
+#else
+        return Path::scalar;
+#endif
+    }
+
+    // Sets on_track[i] to 1 if (xs[i], ys[i]) is on the track or within `margin` of its edge, and
+    // to 0 otherwise
+    void on_track(const float* xs, const float* ys, size_t count, float margin,
+                  uint8_t* on_track) const
+    {
+        on_track_with(best_path(), xs, ys, count, margin, on_track);
+    }
+
+    // As on_track(), through a particular path, which must be one this CPU supports
+    void on_track_with(Path path, const float* xs, const float* ys, size_t count, float margin,
+                       uint8_t* on_track) const
+    {
+        size_t done = 0;
+#if defined(RC_TRACK_QUERY_AVX2)
+        // Gathers address the samples with 32 bit offsets
+        const auto sample_count = _field.columns() * _field.rows();
+        if (path == Path::avx2 && sample_count <= static_cast<size_t>(INT32_MAX)) {
+            done += on_track_avx2(xs, ys, count, margin, on_track);
+        }
+#endif
+#if defined(RC_TRACK_QUERY_SSE2)
+        // SSE2 also takes the few points left over from AVX2
+        if (path != Path::scalar) {
+            done += on_track_sse2(xs + done, ys + done, count - done, margin, on_track + done);
+        }
+#endif
+        for (size_t i = done; i < count; ++i) {
+            on_track[i] = _field.is_on_track({xs[i], ys[i]}, margin) ? 1 : 0;
+        }
+    }
+
+  private:
+#if defined(RC_TRACK_QUERY_SSE2)
+    // Returns how many of the points it answered, a multiple of four
+    size_t on_track_sse2(const float* xs, const float* ys, size_t count, float margin,
+                         uint8_t* on_track) const
+    {
+        const auto origin_x = _mm_set1_ps(_field.origin().x);
+        const auto origin_y = _mm_set1_ps(_field.origin().y);
+        const auto inverse_cell_size = _mm_set1_ps(_field.inverse_cell_size());
+        const auto cell_size = _mm_set1_ps(_field.cell_size());
+        const auto max_u = _mm_set1_ps(static_cast<float>(_field.columns() - 1));
+        const auto max_v = _mm_set1_ps(static_cast<float>(_field.rows() - 1));
+        const auto last_column = _mm_set1_ps(static_cast<float>(_field.columns() - 2));
+        const auto last_row = _mm_set1_ps(static_cast<float>(_field.rows() - 2));
+        const auto zero = _mm_setzero_ps();
+        const auto limit = _mm_set1_ps(margin);
+        const auto columns = _field.columns();
+        const auto* distances = _field.distances();
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const auto u =
+                _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xs + i), origin_x), inverse_cell_size);
+            const auto v =
+                _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(ys + i), origin_y), inverse_cell_size);
+            // maxps returns its second operand for NaN, so NaN lands on 0 as in the field
+            const auto cu = _mm_min_ps(_mm_max_ps(u, zero), max_u);
+            const auto cv = _mm_min_ps(_mm_max_ps(v, zero), max_v);
+            const auto ex = _mm_mul_ps(_mm_sub_ps(u, cu), cell_size);
+            const auto ey = _mm_mul_ps(_mm_sub_ps(v, cv), cell_size);
+            const auto outside = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+            const auto column = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(cu)), last_column);
+            const auto row = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(cv)), last_row);
+            const auto fx = _mm_sub_ps(cu, column);
+            const auto fy = _mm_sub_ps(cv, row);
+
+            // SSE2 has no gather, so the samples are loaded a lane at a time
+            alignas(16) int32_t column_index[4];
+            alignas(16) int32_t row_index[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(column_index), _mm_cvttps_epi32(column));
+            _mm_store_si128(reinterpret_cast<__m128i*>(row_index), _mm_cvttps_epi32(row));
+            const float* lane[4];
+            for (int k = 0; k < 4; ++k) {
+                lane[k] = distances + static_cast<size_t>(row_index[k]) * columns +
+                          static_cast<size_t>(column_index[k]);
+            }
+            const auto d0 = _mm_setr_ps(lane[0][0], lane[1][0], lane[2][0], lane[3][0]);
+            const auto d1 = _mm_setr_ps(lane[0][1], lane[1][1], lane[2][1], lane[3][1]);
+            const auto d2 = _mm_setr_ps(lane[0][columns], lane[1][columns], lane[2][columns],
+                                        lane[3][columns]);
+            const auto d3 = _mm_setr_ps(lane[0][columns + 1], lane[1][columns + 1],
+                                        lane[2][columns + 1], lane[3][columns + 1]);
+
+            const auto top = _mm_add_ps(d0, _mm_mul_ps(_mm_sub_ps(d1, d0), fx));
+            const auto bottom = _mm_add_ps(d2, _mm_mul_ps(_mm_sub_ps(d3, d2), fx));
+            const auto distance =
+                _mm_add_ps(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy)), outside);
+            const int lanes = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+            for (int k = 0; k < 4; ++k) {
+                on_track[i + static_cast<size_t>(k)] = static_cast<uint8_t>((lanes >> k) & 1);
+            }
+        }
+        return i;
+    }
+#endif
+
+#if defined(RC_TRACK_QUERY_AVX2)
+    // Returns how many of the points it answered, a multiple of eight
+    RC_TARGET_AVX2 size_t on_track_avx2(const float* xs, const float* ys, size_t count,
+                                        float margin, uint8_t* on_track) const
+    {
+        const auto origin_x = _mm256_set1_ps(_field.origin().x);
+        const auto origin_y = _mm256_set1_ps(_field.origin().y);
+        const auto inverse_cell_size = _mm256_set1_ps(_field.inverse_cell_size());
+        const auto cell_size = _mm256_set1_ps(_field.cell_size());
+        const auto max_u = _mm256_set1_ps(static_cast<float>(_field.columns() - 1));
+        const auto max_v = _mm256_set1_ps(static_cast<float>(_field.rows() - 1));
+        const auto last_column = _mm256_set1_ps(static_cast<float>(_field.columns() - 2));
+        const auto last_row = _mm256_set1_ps(static_cast<float>(_field.rows() - 2));
+        const auto zero = _mm256_setzero_ps();
+        const auto limit = _mm256_set1_ps(margin);
+        const auto columns = _mm256_set1_epi32(static_cast<int32_t>(_field.columns()));
+        const auto one = _mm256_set1_epi32(1);
+        const auto* distances = _field.distances();
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const auto u =
+                _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(xs + i), origin_x), inverse_cell_size);
+            const auto v =
+                _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(ys + i), origin_y), inverse_cell_size);
+            const auto cu = _mm256_min_ps(_mm256_max_ps(u, zero), max_u);
+            const auto cv = _mm256_min_ps(_mm256_max_ps(v, zero), max_v);
+            const auto ex = _mm256_mul_ps(_mm256_sub_ps(u, cu), cell_size);
+            const auto ey = _mm256_mul_ps(_mm256_sub_ps(v, cv), cell_size);
+            const auto outside =
+                _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey)));
+            const auto column =
+                _mm256_min_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(cu)), last_column);
+            const auto row = _mm256_min_ps(_mm256_cvtepi32_ps(_mm256_cvttps_epi32(cv)), last_row);
+            const auto fx = _mm256_sub_ps(cu, column);
+            const auto fy = _mm256_sub_ps(cv, row);
+
+            const auto index0 = _mm256_add_epi32(
+                _mm256_mullo_epi32(_mm256_cvttps_epi32(row), columns), _mm256_cvttps_epi32(column));
+            const auto index2 = _mm256_add_epi32(index0, columns);
+            const auto d0 = _mm256_i32gather_ps(distances, index0, 4);
+            const auto d1 = _mm256_i32gather_ps(distances, _mm256_add_epi32(index0, one), 4);
+            const auto d2 = _mm256_i32gather_ps(distances, index2, 4);
+            const auto d3 = _mm256_i32gather_ps(distances, _mm256_add_epi32(index2, one), 4);
+
+            const auto top = _mm256_add_ps(d0, _mm256_mul_ps(_mm256_sub_ps(d1, d0), fx));
+            const auto bottom = _mm256_add_ps(d2, _mm256_mul_ps(_mm256_sub_ps(d3, d2), fx));
+            const auto distance = _mm256_add_ps(
+                _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), fy)), outside);
+            const int lanes = _mm256_movemask_ps(_mm256_cmp_ps(distance, limit, _CMP_LE_OQ));
+            for (int k = 0; k < 8; ++k) {
+                on_track[i + static_cast<size_t>(k)] = static_cast<uint8_t>((lanes >> k) & 1);
+            }
+        }
+        return i;
+    }
+#endif
+
+    const TrackDistanceField& _field;
+};
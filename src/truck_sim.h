@@ -0,0 +1,143 @@
+#pragma once
+
+#include "input_state.h"
+#include "track_field.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// How the truck handles. These stay fixed while it drives.
+struct TruckParameters {
+    float friction = 2.4f;
+    float max_power = 126.0f;
+    float acceleration = 0.3f;
+    float turn_rate = 3.0f; // Radians per second
+};
+
+// Everything about the truck that the simulation advances
+struct TruckState {
+    glm::vec2 position{0};
+    float angle = 0;
+    glm::vec2 velocity{0};
+    float power = 0;
+};
+
+// The simulation always advances in ticks of this length, whatever rate frames are drawn at. At
+// top speed the truck covers under half a unit per tick, far less than the width of the track,
+// so it cannot skip past the edge clamping.
+constexpr double truck_tick_seconds = 1.0 / 120.0;
+
+// Advances `truck` by one tick and keeps it on the track. The result depends on nothing but the
+// arguments, so the same start state and input sequence reproduce the same states bit for bit.
+inline void step_truck(TruckState& truck, const InputState& input,
+                       const TrackDistanceField& track_field,
+                       const TruckParameters& parameters = {})
+{
+    constexpr auto dt = static_cast<float>(truck_tick_seconds);
+    if (input.left) {
+        truck.angle += parameters.turn_rate * dt;
+    } else if (input.right) {
+        truck.angle -= parameters.turn_rate * dt;
+    }
+
+    if (input.accel) {
+        truck.power += parameters.acceleration * dt;
+    } else {
+        truck.power -= parameters.acceleration * 3.0f * dt;
+    }
+    truck.power = std::clamp(truck.power, 0.0f, 1.0f);
+
+    // Forward is -z at an angle of 0
+    const glm::vec2 direction{-std::sin(truck.angle), -std::cos(truck.angle)};
+    truck.velocity += direction * (truck.power * parameters.max_power * dt);
+    truck.velocity += truck.velocity * (-parameters.friction * dt);
+    truck.position += truck.velocity * dt;
+
+    track_field.clamp(truck.position);
+}
+
+// The state `alpha` of the way from `previous` to `current`, for drawing between ticks.
+inline TruckState interpolate(const TruckState& previous, const TruckState& current, float alpha)
+{
+    return {glm::mix(previous.position, current.position, alpha),
+            previous.angle + (current.angle - previous.angle) * alpha,
+            glm::mix(previous.velocity, current.velocity, alpha),
+            previous.power + (current.power - previous.power) * alpha};
+}
+
+// The centre of the edge between two neighbouring tiles, which is always on the racing line
+inline glm::vec2 tile_border(const TrackLayout& track_layout, const std::pair<size_t, size_t>& a,
+                             const std::pair<size_t, size_t>& b)
+{
+    return (track_layout.at(a).centre + track_layout.at(b).centre) * 0.5f;
+}
+
+// Steers towards the far edge of the next segment, and eases off the power for sharp turns. Used
+// by the headless simulator and by the computer driven trucks in the game.
+inline InputState autopilot(const TruckState& truck, const RaceProgress& progress,
+                            const TrackLayout& track_layout,
+                            const std::vector<std::pair<size_t, size_t>>& order)
+{
+    const auto next = (progress.segments_reached + 1) % order.size();
+    const auto after_next = (next + 1) % order.size();
+    const auto to_target =
+        tile_border(track_layout, order[next], order[after_next]) - truck.position;
+    const auto distance = glm::length(to_target);
+    if (distance <= 0) {
+        return {false, false, true, false};
+    }
+
+    // Turning left swings the forward direction towards `left`
+    const glm::vec2 forward{-std::sin(truck.angle), -std::cos(truck.angle)};
+    const glm::vec2 left{-std::cos(truck.angle), std::sin(truck.angle)};
+    const auto ahead = glm::dot(forward, to_target) / distance;
+    const auto side = glm::dot(left, to_target) / distance;
+
+    InputState input;
+    input.left = side > 0.05f || (ahead < 0 && side >= 0);
+    input.right = !input.left && (side < -0.05f || ahead < 0);
+    input.accel = ahead > 0.7f;
+    return input;
+}
+
+// Turns the real time between frames into a whole number of fixed ticks, carrying the remainder
+// over to the next frame.
+class FixedTimestep {
+  public:
+    explicit FixedTimestep(double tick_seconds, size_t max_ticks_per_frame = 15)
+        : _tick_seconds(tick_seconds), _max_ticks_per_frame(max_ticks_per_frame)
+    {
+    }
+
+    // Adds a frame's worth of time and returns how many ticks to run for it. Time beyond
+    // `max_ticks_per_frame` ticks is dropped, so after a long stall the game slows down for a
+    // frame rather than freezing while it catches up.
+    size_t advance(double frame_seconds)
+    {
+        _accumulator += std::max(frame_seconds, 0.0);
+        auto ticks = static_cast<size_t>(_accumulator / _tick_seconds);
+        if (ticks > _max_ticks_per_frame) {
+            ticks = _max_ticks_per_frame;
+            _accumulator = 0;
+            return ticks;
+        }
+        _accumulator -= static_cast<double>(ticks) * _tick_seconds;
+        return ticks;
+    }
+
+    // How far the frame is from the last tick towards the next, in [0, 1)
+    float alpha() const
+    {
+        return std::clamp(static_cast<float>(_accumulator / _tick_seconds), 0.0f, 1.0f);
+    }
+
+  private:
+    double _tick_seconds;
+    size_t _max_ticks_per_frame;
+    double _accumulator = 0;
+};
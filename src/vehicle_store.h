@@ -0,0 +1,99 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "track_field.h"
+#include "truck_sim.h"
+
+#include <cstddef>
+#include <vector>
+
+// Every truck on the track, the player's and the computer's, kept as a structure of arrays so
+// that one tick walks each field contiguously however many trucks there are. Trees and other
+// props never move and stay out of here.
+//
+// Each tick keeps the states it started from, so frames can draw every truck between ticks.
+class VehicleStore {
+  public:
+    // Trucks are stepped in ranges of this many, each range on whichever thread claims it
+    static constexpr size_t vehicles_per_range = 16;
+
+    // Adds a truck and returns its index, which stays the same for as long as the store lives
+    size_t add(const TruckState& state, const TruckParameters& parameters = {})
+    {
+        _current.push_back(state);
+        _previous.push_back(state);
+        _parameters.push_back(parameters);
+        return _parameters.size() - 1;
+    }
+
+    size_t size() const { return _parameters.size(); }
+
+    // The state of truck `vehicle` after the last tick
+    TruckState state(size_t vehicle) const { return _current.get(vehicle); }
+
+    // Truck `vehicle` `alpha` of the way from the previous tick to the last
+    TruckState interpolated(size_t vehicle, float alpha) const
+    {
+        return interpolate(_previous.get(vehicle), _current.get(vehicle), alpha);
+    }
+
+    const TruckParameters& parameters(size_t vehicle) const { return _parameters[vehicle]; }
+
+    // Advances every truck by one tick with step_truck(), spread over `pool`. `input(vehicle,
+    // state)` returns the keys held for a truck, and is called from several threads at once, so
+    // it must only read shared data.
+    template <typename InputFor>
+    void step(const TrackDistanceField& track_field, ThreadPool& pool, InputFor&& input)
+    {
+        _previous = _current;
+        pool.parallel_for_ranges(size(), vehicles_per_range, [&](size_t begin, size_t end) {
+            for (size_t vehicle = begin; vehicle < end; ++vehicle) {
+                auto state = _current.get(vehicle);
+                const InputState held = input(vehicle, state);
+                step_truck(state, held, track_field, _parameters[vehicle]);
+                _current.set(vehicle, state);
+            }
+        });
+    }
+
+  private:
+    // One array per TruckState field
+    struct Columns {
+        std::vector<float> position_x;
+        std::vector<float> position_z;
+        std::vector<float> angle;
+        std::vector<float> velocity_x;
+        std::vector<float> velocity_z;
+        std::vector<float> power;
+
+        TruckState get(size_t i) const
+        {
+            return {{position_x[i], position_z[i]}, angle[i], {velocity_x[i], velocity_z[i]},
+                    power[i]};
+        }
+
+        void set(size_t i, const TruckState& state)
+        {
+            position_x[i] = state.position.x;
+            position_z[i] = state.position.y;
+            angle[i] = state.angle;
+            velocity_x[i] = state.velocity.x;
+            velocity_z[i] = state.velocity.y;
+            power[i] = state.power;
+        }
+
+        void push_back(const TruckState& state)
+        {
+            position_x.push_back(state.position.x);
+            position_z.push_back(state.position.y);
+            angle.push_back(state.angle);
+            velocity_x.push_back(state.velocity.x);
+            velocity_z.push_back(state.velocity.y);
+            power.push_back(state.power);
+        }
+    };
+
+    Columns _current;
+    Columns _previous;
+    std::vector<TruckParameters> _parameters;
+};
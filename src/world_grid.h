@@ -0,0 +1,142 @@
+#pragma once
+
+#include "model.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Axis aligned bounding box. A default constructed box is empty and contains nothing.
+struct Aabb {
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+    bool empty() const { return min.x > max.x; }
+
+    void include(const Aabb& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+};
+
+inline Aabb mesh_bounds(const ModelView& mesh)
+{
+    Aabb result;
+    for (size_t i = 0; i < mesh.vertex_count; ++i) {
+        const glm::vec3 position{mesh.vertices[i].pos};
+        result.min = glm::min(result.min, position);
+        result.max = glm::max(result.max, position);
+    }
+    return result;
+}
+
+// Bounds of a mesh with bounds `local` once it is scaled by `scale`, spun about the up axis and
+// moved to `position` on the ground plane. The box is loose enough to hold it at any angle.
+inline Aabb placed_bounds(const Aabb& local, const glm::vec2& position, float scale)
+{
+    if (local.empty()) {
+        return local;
+    }
+    const glm::vec2 farthest_corner =
+        glm::max(glm::abs(glm::vec2{local.min.x, local.min.z}),
+                 glm::abs(glm::vec2{local.max.x, local.max.z}));
+    const auto radius = glm::length(farthest_corner) * scale;
+    return {{position.x - radius, local.min.y * scale, position.y - radius},
+            {position.x + radius, local.max.y * scale, position.y + radius}};
+}
+
+// The six clip planes of a view-projection matrix, each facing inwards.
+class Frustum {
+  public:
+    explicit Frustum(const glm::mat4& view_projection)
+    {
+        // glm is column major, so row i of the matrix is m[0][i], m[1][i], m[2][i], m[3][i]
+        const auto row = [&](int i) {
+            return glm::vec4{view_projection[0][i], view_projection[1][i], view_projection[2][i],
+                             view_projection[3][i]};
+        };
+        for (int axis = 0; axis < 3; ++axis) {
+            _planes[static_cast<size_t>(axis) * 2] = row(3) + row(axis);
+            _planes[static_cast<size_t>(axis) * 2 + 1] = row(3) - row(axis);
+        }
+    }
+
+    // Conservative: a box straddling the frustum's corner region may be reported as visible.
+    bool intersects(const Aabb& box) const
+    {
+        for (const auto& plane : _planes) {
+            // The box corner furthest along the plane normal
+            const glm::vec3 corner{plane.x >= 0 ? box.max.x : box.min.x,
+                                   plane.y >= 0 ? box.max.y : box.min.y,
+                                   plane.z >= 0 ? box.max.z : box.min.z};
+            if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    std::array<glm::vec4, 6> _planes;
+};
+
+// Partitions a track layout's tile grid into square chunks of `tiles_per_chunk` x
+// `tiles_per_chunk` tiles. Tile (row, column) is centred on (column, row) * tile_size on the
+// ground plane, like translate_track_layout lays it out. Each chunk keeps the bounds of whatever
+// has been placed in it, so whole chunks can be culled at once.
+class WorldGrid {
+  public:
+    static constexpr float tile_size = 60.0f;
+
+    WorldGrid(size_t tile_rows, size_t tile_columns, size_t tiles_per_chunk)
+        : _tiles_per_chunk(std::max<size_t>(tiles_per_chunk, 1)),
+          _rows((tile_rows + _tiles_per_chunk - 1) / _tiles_per_chunk),
+          _columns((tile_columns + _tiles_per_chunk - 1) / _tiles_per_chunk),
+          _bounds(_rows * _columns)
+    {
+    }
+
+    size_t chunk_count() const { return _bounds.size(); }
+
+    // The chunk holding `point` on the ground plane. Points beyond the edge of the layout belong
+    // to the nearest edge chunk, which grows to fit them.
+    size_t chunk_at(const glm::vec2& point) const
+    {
+        const auto row = chunk_coordinate(point.y, _rows);
+        const auto column = chunk_coordinate(point.x, _columns);
+        return row * _columns + column;
+    }
+
+    const Aabb& bounds(size_t chunk) const { return _bounds[chunk]; }
+
+    void include(size_t chunk, const Aabb& box) { _bounds[chunk].include(box); }
+
+    // Appends every non-empty chunk that `frustum` can see to `result`.
+    void visible_chunks(const Frustum& frustum, std::vector<size_t>& result) const
+    {
+        for (size_t chunk = 0; chunk < _bounds.size(); ++chunk) {
+            if (!_bounds[chunk].empty() && frustum.intersects(_bounds[chunk])) {
+                result.push_back(chunk);
+            }
+        }
+    }
+
+  private:
+    size_t chunk_coordinate(float world, size_t chunk_count) const
+    {
+        const auto tile = std::floor((world + tile_size / 2) / tile_size);
+        const auto chunk = std::floor(tile / static_cast<float>(_tiles_per_chunk));
+        return static_cast<size_t>(std::clamp(chunk, 0.0f, static_cast<float>(chunk_count - 1)));
+    }
+
+    size_t _tiles_per_chunk;
+    size_t _rows;
+    size_t _columns;
+    std::vector<Aabb> _bounds;
+};
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <frame_report.h>
+
+#include <sstream>
+
+TEST(InputScript, HoldsKeysUntilTheNextLine)
+{
+    const InputScript script(R"(# warm up, then turn left
+                                10 W
+                                20 wa
+                                30 -)");
+
+    EXPECT_FALSE(script.at(0).accel);
+    EXPECT_FALSE(script.at(9).accel);
+    EXPECT_TRUE(script.at(10).accel);
+    EXPECT_FALSE(script.at(10).left);
+    EXPECT_TRUE(script.at(25).accel);
+    EXPECT_TRUE(script.at(25).left);
+    EXPECT_FALSE(script.at(30).accel);
+    EXPECT_FALSE(script.at(1000).left);
+}
+
+TEST(InputScript, AcceptsLinesOutOfOrder)
+{
+    const InputScript script("20 S\n0 D\n");
+
+    EXPECT_TRUE(script.at(5).right);
+    EXPECT_TRUE(script.at(20).reverse);
+    EXPECT_FALSE(script.at(20).right);
+}
+
+TEST(FrameReport, SummarisesTimesAndSubmissions)
+{
+    FrameReport report;
+    for (int i = 1; i <= 100; ++i) {
+        report.add(static_cast<double>(i), {static_cast<size_t>(i % 7), 1000});
+    }
+
+    EXPECT_EQ(report.frame_count(), 100u);
+    EXPECT_DOUBLE_EQ(report.mean_milliseconds(), 50.5);
+    EXPECT_DOUBLE_EQ(report.percentile_milliseconds(0.95), 95.0);
+    EXPECT_DOUBLE_EQ(report.percentile_milliseconds(1.0), 100.0);
+    EXPECT_EQ(report.max_stats().draw_calls, 6u);
+    EXPECT_EQ(report.max_stats().triangles, 1000u);
+
+    std::ostringstream text;
+    report.write(text);
+    EXPECT_NE(text.str().find("frames 100\n"), std::string::npos);
+    EXPECT_NE(text.str().find("draw_calls_max 6\n"), std::string::npos);
+}
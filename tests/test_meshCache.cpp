@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+
+#include <mesh_cache.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+static const char* triangle_obj = R"(o Triangle
+v 0.0 0.0 0.0
+v 1.0 0.0 0.0
+v 0.0 1.0 0.0
+vt 0.0 0.0
+vt 1.0 0.0
+vt 0.0 1.0
+vn 0.0 0.0 1.0
+f 1/1/1 2/2/1 3/3/1
+o Quad
+v 1.0 1.0 0.0
+f 2/2/1 4/3/1 3/1/1 1/1/1
+)";
+
+static std::map<std::string, Model> models_from_text(const char* text)
+{
+    ObjFile obj;
+    obj.process_text(text);
+
+    std::map<std::string, Model> result;
+    for (const auto& name : obj.objects()) {
+        result[name] = model_from_mesh(obj.produce_indexed_mesh(name));
+    }
+    return result;
+}
+
+static bool same_model(const ModelView& view, const Model& model)
+{
+    return view.vertex_count == model.vertices.size() &&
+           view.index_count == model.indices.size() &&
+           std::memcmp(view.vertices, model.vertices.data(), sizeof(Vertex) * view.vertex_count) ==
+               0 &&
+           std::memcmp(view.indices, model.indices.data(), sizeof(uint32_t) * view.index_count) ==
+               0;
+}
+
+TEST(MeshCache, RoundTripsEveryModel)
+{
+    const auto filename = ::testing::TempDir() + "round_trip.meshcache";
+    const auto models = models_from_text(triangle_obj);
+    ASSERT_TRUE(write_mesh_cache(filename.c_str(), 42, models));
+
+    const MeshCache cache(filename.c_str(), 42);
+    ASSERT_TRUE(cache.is_valid());
+    EXPECT_EQ(cache.names(), (std::vector<std::string>{"Quad", "Triangle"}));
+    EXPECT_TRUE(same_model(cache["Triangle"], models.at("Triangle")));
+    EXPECT_TRUE(same_model(cache["Quad"], models.at("Quad")));
+}
+
+TEST(MeshCache, RejectsStaleSource)
+{
+    const auto filename = ::testing::TempDir() + "stale.meshcache";
+    ASSERT_TRUE(write_mesh_cache(filename.c_str(), 42, models_from_text(triangle_obj)));
+
+    EXPECT_FALSE(MeshCache(filename.c_str(), 43).is_valid());
+}
+
+TEST(MeshCache, RejectsMissingOrTruncatedFile)
+{
+    EXPECT_FALSE(MeshCache("this-file-does-not-exist.meshcache", 0).is_valid());
+
+    const auto filename = ::testing::TempDir() + "truncated.meshcache";
+    std::ofstream(filename) << "RCMC";
+    EXPECT_FALSE(MeshCache(filename.c_str(), 0).is_valid());
+}
+
+TEST(MeshCache, RejectsForgedEntries)
+{
+    const auto filename = ::testing::TempDir() + "forged.meshcache";
+    ASSERT_TRUE(write_mesh_cache(filename.c_str(), 42, models_from_text(triangle_obj)));
+    std::ostringstream contents;
+    contents << std::ifstream(filename, std::ios::binary).rdbuf();
+    const auto bytes = contents.str();
+    MeshCacheEntry original;
+    std::memcpy(&original, bytes.data() + sizeof(MeshCacheHeader), sizeof(original));
+
+    const auto forged = [&](const MeshCacheEntry& entry) {
+        auto copy = bytes;
+        std::memcpy(copy.data() + sizeof(MeshCacheHeader), &entry, sizeof(entry));
+        std::ofstream(filename, std::ios::binary | std::ios::trunc) << copy;
+        return MeshCache(filename.c_str(), 42).is_valid();
+    };
+    EXPECT_TRUE(forged(original));
+
+    // Counts whose byte size wraps around to fit
+    auto entry = original;
+    entry.vertex_count = UINT64_MAX / sizeof(Vertex) + 1;
+    EXPECT_FALSE(forged(entry));
+    entry = original;
+    entry.index_count = UINT64_MAX / sizeof(uint32_t) + 1;
+    EXPECT_FALSE(forged(entry));
+    // An offset so large that adding the size wraps back into the file
+    entry = original;
+    entry.name_offset = UINT64_MAX - 2;
+    EXPECT_FALSE(forged(entry));
+    // In bounds, but not aligned for reading the vertices in place
+    entry = original;
+    entry.vertex_offset += 1;
+    entry.vertex_count = 1;
+    EXPECT_FALSE(forged(entry));
+    std::remove(filename.c_str());
+}
+
+TEST(MeshAssets, FallsBackToObjWhenCacheIsStale)
+{
+    const auto obj_filename = ::testing::TempDir() + "assets.obj";
+    std::ofstream(obj_filename) << triangle_obj;
+    const auto cache_filename = mesh_cache_filename(obj_filename.c_str());
+    const auto models = models_from_text(triangle_obj);
+
+    ASSERT_TRUE(write_mesh_cache(cache_filename.c_str(), 0, models));
+    const MeshAssets stale(obj_filename.c_str());
+    EXPECT_FALSE(stale.from_cache());
+    EXPECT_TRUE(same_model(stale["Quad"], models.at("Quad")));
+
+    ASSERT_TRUE(
+        write_mesh_cache(cache_filename.c_str(), *hash_file(obj_filename.c_str()), models));
+    const MeshAssets fresh(obj_filename.c_str());
+    EXPECT_TRUE(fresh.from_cache());
+    EXPECT_TRUE(same_model(fresh["Quad"], models.at("Quad")));
+}
+
+TEST(MeshAssets, BakesLodLevelsOnlyWhenAsked)
+{
+    const auto obj_filename = ::testing::TempDir() + "lod_assets.obj";
+    std::ofstream(obj_filename) << triangle_obj;
+    std::remove(mesh_cache_filename(obj_filename.c_str()).c_str());
+
+    const MeshAssets with_lods(obj_filename.c_str());
+    EXPECT_NO_THROW(with_lods[lod_name("Quad", 1)]);
+    const MeshAssets without_lods(obj_filename.c_str(), false);
+    EXPECT_NO_THROW(without_lods["Quad"]);
+    EXPECT_THROW(without_lods[lod_name("Quad", 1)], std::out_of_range);
+    std::remove(obj_filename.c_str());
+}
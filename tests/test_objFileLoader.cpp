@@ -6,6 +6,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <algorithm>
+#include <fstream>
 #include <ostream>
 
 static const char* blender_output =
@@ -184,6 +186,19 @@ TEST(objFileLoader, CanReadVectors)
     EXPECT_EQ(obj.vertices, expected);
 }
 
+TEST(objFileLoader, CanReadOptionalVertexWeight)
+{
+    auto text = R"(o Curve
+                   v 1.0 2.0 3.0 0.5
+                   v 1.0 2.0 3.0)";
+
+    ObjFile obj;
+    obj.process_text(text);
+
+    std::vector<ObjFile::Vertex> expected{{1.0f, 2.0f, 3.0f, 0.5f}, {1.0f, 2.0f, 3.0f, 1.0f}};
+    EXPECT_EQ(obj.vertices, expected);
+}
+
 TEST(objFileLoader, CanReadTextureCoordinates)
 {
     auto text = R"(o Cube
@@ -279,4 +294,221 @@ TEST(objFileLoader, CanMultipleObjects)
     obj.produce_triangle_list("B", &collector);
 
     ASSERT_EQ(collector.vertices, expected);
-}
\ No newline at end of file
+}
+
+TEST(objFileLoader, CanProcessFile)
+{
+    const auto filename = ::testing::TempDir() + "cube.obj";
+    std::ofstream(filename) << blender_output;
+
+    ObjFile from_file;
+    ASSERT_TRUE(from_file.process_file(filename.c_str()));
+
+    ObjFile from_text;
+    from_text.process_text(blender_output);
+
+    ASSERT_EQ(from_file.objects(), from_text.objects());
+    EXPECT_EQ(from_file.vertices, from_text.vertices);
+    EXPECT_EQ(from_file.tex_coords, from_text.tex_coords);
+    EXPECT_EQ(from_file.vertex_normals, from_text.vertex_normals);
+    EXPECT_EQ(from_file["Cube"].faces, from_text["Cube"].faces);
+}
+
+TEST(objFileLoader, ReportsMissingFile)
+{
+    ObjFile obj;
+    EXPECT_FALSE(obj.process_file("this-file-does-not-exist.obj"));
+    EXPECT_EQ(obj.object_count(), 0);
+}
+
+TEST(objFileLoader, ParallelParseMatchesSerial)
+{
+    auto text = R"(f 1/1/1 1/1/1 1/1/1
+                   o A
+                   v 0.0 0.25 0.5
+                   vt 0.0 1.0
+                   vn 0.25 0.5 1.0
+                   f 1/1/1 1/1/1 1/1/1
+                   o B
+                   v 0.5 0.25 0.0
+                   vt 1.0 0.0
+                   vn 1.0 0.5 0.25
+                   f 1/2/2 2/1/2 2/1/1
+                   o A
+                   f 2/2/2 1/1/1 2/2/2
+                   f 2/1/2 1/2/1 2/1/2
+                   v 0.0 0.0 0.0
+                   v 2.0 1.0 0.0
+                   v 0.0 2.0 0.0
+                   v 1.0 1.0 0.0
+                   f 3/1/1 4/1/1 5/1/1 6/1/1
+                   f 6/1/1 3/1/1 4/1/1 5/1/1
+                   )";
+
+    ObjFile serial;
+    serial.process_text(text);
+
+    // Parse with a tiny chunk size so every few lines land on a different worker.
+    ThreadPool pool(4);
+    ObjFile parallel;
+    parallel.process_text_parallel(text, pool, 16);
+
+    ASSERT_EQ(parallel.objects(), serial.objects());
+    EXPECT_EQ(parallel.vertices, serial.vertices);
+    EXPECT_EQ(parallel.tex_coords, serial.tex_coords);
+    EXPECT_EQ(parallel.vertex_normals, serial.vertex_normals);
+    EXPECT_EQ(parallel[""].faces, serial[""].faces);
+    EXPECT_EQ(parallel["A"].faces, serial["A"].faces);
+    EXPECT_EQ(parallel["B"].faces, serial["B"].faces);
+}
+
+TEST(objFileLoader, CanProduceIndexedMesh)
+{
+    ObjFile obj;
+    obj.process_text(blender_output);
+
+    TestCollector collector;
+    obj.produce_triangle_list("Cube", &collector);
+
+    const auto mesh = obj.produce_indexed_mesh<uint16_t>("Cube");
+
+    // Each of the 6 sides shares its 4 corners between 2 triangles.
+    ASSERT_EQ(mesh.vertices.size(), 24);
+    ASSERT_EQ(mesh.indices.size(), collector.vertices.size());
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        const auto& vertex = mesh.vertices[mesh.indices[i]];
+        EXPECT_EQ(collector.vertices[i],
+                  (TestCollector::Vertex{
+                      {vertex.position.x, vertex.position.y, vertex.position.z, vertex.position.w},
+                      {vertex.tex.u, vertex.tex.v},
+                      {vertex.normal.x, vertex.normal.y, vertex.normal.z}}));
+    }
+}
+
+TEST(objFileLoader, FillsInMissingTextureCoordinatesAndNormals)
+{
+    // One face without texture coordinates, and one with neither, both facing +z
+    auto text = R"(o Tris
+                   v 0.0 0.0 0.0
+                   v 1.0 0.0 0.0
+                   v 0.0 1.0 0.0
+                   v 1.0 1.0 0.0
+                   vn 0.0 0.0 1.0
+                   f 1//1 2//1 3//1
+                   f 2 4 3
+                   )";
+    ObjFile obj;
+    obj.process_text(text);
+
+    TestCollector collector;
+    obj.produce_triangle_list("Tris", &collector);
+    ASSERT_EQ(collector.vertices.size(), 6);
+    for (const auto& vertex : collector.vertices) {
+        EXPECT_EQ(vertex.t, glm::vec2(0.0f, 0.0f));
+        EXPECT_EQ(vertex.n, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    const auto mesh = obj.produce_indexed_mesh("Tris");
+    ASSERT_EQ(mesh.indices.size(), 6);
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        const auto& vertex = mesh.vertices[mesh.indices[i]];
+        EXPECT_EQ(collector.vertices[i].v, glm::vec4(vertex.position.x, vertex.position.y,
+                                                     vertex.position.z, vertex.position.w));
+        EXPECT_EQ(vertex.normal, (ObjFile::VertexNormal{0.0f, 0.0f, 1.0f}));
+    }
+}
+
+TEST(objFileLoader, CanTriangulateConvexPolygons)
+{
+    auto text = R"(o Quad
+                   v 0.0 0.0 0.0
+                   v 1.0 0.0 0.0
+                   v 1.0 1.0 0.0
+                   v 0.0 1.0 0.0
+                   f 1/1/1 2/2/2 3/3/3 4/4/4
+                   )";
+    ObjFile obj;
+    obj.process_text(text);
+
+    ASSERT_EQ(obj["Quad"].faces.size(), 2);
+    EXPECT_EQ(obj["Quad"].faces[0], (ObjFile::Face{{1, 1, 1}, {2, 2, 2}, {3, 3, 3}}));
+    EXPECT_EQ(obj["Quad"].faces[1], (ObjFile::Face{{1, 1, 1}, {3, 3, 3}, {4, 4, 4}}));
+}
+
+TEST(objFileLoader, CanTriangulateConcavePolygons)
+{
+    // An arrowhead whose 4th corner is reflex. Fanning from corner 1 would cover the notch, so
+    // both triangles have to share the 2-4 diagonal instead.
+    auto text = R"(o Dart
+                   v 0.0 0.0 0.0
+                   v 2.0 1.0 0.0
+                   v 0.0 2.0 0.0
+                   v 1.0 1.0 0.0
+                   f 1/1/1 2/1/1 3/1/1 4/1/1
+                   )";
+    ObjFile obj;
+    obj.process_text(text);
+
+    const auto faces = obj["Dart"].faces;
+    ASSERT_EQ(faces.size(), 2);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const auto& corners = faces[i].indices;
+        const auto uses = [&corners](int v) {
+            return std::any_of(corners.begin(), corners.end(),
+                               [v](const auto& corner) { return corner.vertex == v; });
+        };
+        EXPECT_TRUE(uses(2) && uses(4)) << faces[i];
+    }
+}
+
+TEST(objFileLoader, StreamingParseMatchesWholeText)
+{
+    const std::string_view text = blender_output;
+    ObjFile whole;
+    whole.process_text(text);
+
+    // Small chunk sizes split lines, and even the numbers within them, at every possible point.
+    for (const size_t chunk_size : {1u, 2u, 3u, 7u, 64u, 4096u}) {
+        ObjFile streamed;
+        for (size_t i = 0; i < text.size(); i += chunk_size) {
+            streamed.feed(text.substr(i, chunk_size));
+        }
+        streamed.finish();
+
+        ASSERT_EQ(streamed.objects(), whole.objects()) << "chunk size " << chunk_size;
+        EXPECT_EQ(streamed.vertices, whole.vertices) << "chunk size " << chunk_size;
+        EXPECT_EQ(streamed.tex_coords, whole.tex_coords) << "chunk size " << chunk_size;
+        EXPECT_EQ(streamed.vertex_normals, whole.vertex_normals) << "chunk size " << chunk_size;
+        EXPECT_EQ(streamed["Cube"].faces, whole["Cube"].faces) << "chunk size " << chunk_size;
+    }
+}
+
+TEST(objFileLoader, ReportsObjectsAsTheyComplete)
+{
+    std::vector<std::pair<std::string, size_t>> completed;
+    ObjFile obj;
+    obj.on_object_complete([&completed](const ObjFile& file, const std::string& name) {
+        completed.push_back({name, file[name].faces.size()});
+    });
+
+    obj.feed("o A\nv 0.0 0.25 0.5\nvt 0.0 1.0\nvn 0.25 0.5 1.0\nf 1/1/1 1/1/1 1/1/1\no");
+    EXPECT_TRUE(completed.empty());
+    obj.feed(" B\nf 1/1/1 1/1/1 1/1/1\nf 1/1/1 1/1/1 1/1/1");
+    EXPECT_EQ(completed, (std::vector<std::pair<std::string, size_t>>{{"A", 1}}));
+    obj.finish();
+    EXPECT_EQ(completed, (std::vector<std::pair<std::string, size_t>>{{"A", 1}, {"B", 2}}));
+}
+
+TEST(objFileLoader, ReportsEachObjectOnceIncludingLeadingUnnamedFaces)
+{
+    std::vector<std::string> completed;
+    ObjFile obj;
+    obj.on_object_complete(
+        [&completed](const ObjFile&, const std::string& name) { completed.push_back(name); });
+
+    obj.feed("v 0.0 0.25 0.5\nf 1 1 1\no A\nf 1 1 1\no B\nf 1 1 1\no A\nf 1 1 1\n");
+    obj.finish();
+    EXPECT_EQ(completed, (std::vector<std::string>{"", "A", "B"}));
+    EXPECT_EQ(obj[""].faces.size(), 1);
+    EXPECT_EQ(obj["A"].faces.size(), 2);
+}
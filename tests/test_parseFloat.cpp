@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <parse_float.h>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+
+static float from_chars_float(const std::string& s)
+{
+    float value = 0;
+    std::from_chars(s.data(), s.data() + s.size(), value);
+    return value;
+}
+
+TEST(ParseFloat, TakesFastPathForFixedPointDecimals)
+{
+    for (const auto* s : {"0", "-0.833333", "1.000000", "12.345678", "5.", ".5", "0.00000001"}) {
+        float value = -42;
+        EXPECT_TRUE(parse_fixed_point_float(s, value)) << s;
+        EXPECT_EQ(value, from_chars_float(s)) << s;
+    }
+}
+
+TEST(ParseFloat, FallsBackForEverythingElse)
+{
+    // Too many significant digits, too many decimals, exponents and non-numbers.
+    for (const auto* s : {"123456789.5", "16777216", "0.123456789", "1e3", "inf", "-", ".", ""}) {
+        float value = -42;
+        EXPECT_FALSE(parse_fixed_point_float(s, value)) << s;
+        EXPECT_EQ(value, -42) << s;
+    }
+
+    EXPECT_EQ(parse_float("123456789.5"), 123456789.5f);
+    EXPECT_EQ(parse_float("1e3"), 1000.0f);
+    EXPECT_EQ(parse_float("+2.5"), 2.5f);
+    EXPECT_EQ(parse_float("garbage", 7.0f), 7.0f);
+}
+
+TEST(ParseFloat, KeepsSignOfNegativeZero)
+{
+    EXPECT_TRUE(std::signbit(parse_float("-0.000000")));
+}
+
+TEST(ParseFloat, RoundsExactlyLikeFromChars)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> distribution(-100.0, 100.0);
+    char text[64];
+    for (int i = 0; i < 100000; ++i) {
+        const auto precision = i % 9;
+        snprintf(text, sizeof(text), "%.*f", precision, distribution(rng));
+        ASSERT_EQ(parse_float(text), from_chars_float(text)) << text;
+    }
+}
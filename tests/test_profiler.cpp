@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <profiler.h>
+
+#include <sstream>
+
+TEST(Profiler, RecordsNothingWhileDisabled)
+{
+    Profiler profiler;
+    {
+        const ProfileScope scope(profiler, "Ignored");
+    }
+    profiler.record("Ignored", 0, 1, Profiler::Track::gpu, 0);
+    EXPECT_EQ(profiler.size(), 0u);
+}
+
+TEST(Profiler, ScopesRecordOnTheCpuTrack)
+{
+    Profiler profiler;
+    profiler.set_enabled(true);
+    profiler.begin_frame(7);
+    {
+        const ProfileScope outer(profiler, "Outer");
+        const ProfileScope inner(profiler, "Inner");
+    }
+
+    const auto events = profiler.events();
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_STREQ(events[0].name, "Inner");
+    EXPECT_STREQ(events[1].name, "Outer");
+    EXPECT_LE(events[1].start_ns, events[0].start_ns);
+    EXPECT_GE(events[1].duration_ns, events[0].duration_ns);
+    EXPECT_EQ(events[1].frame, 7u);
+    EXPECT_EQ(events[1].track, Profiler::Track::cpu);
+}
+
+TEST(Profiler, KeepsOnlyTheNewestEvents)
+{
+    Profiler profiler(3);
+    profiler.set_enabled(true);
+    for (uint64_t i = 0; i < 5; ++i) {
+        profiler.record("Event", i, 1, Profiler::Track::cpu, i);
+    }
+
+    const auto events = profiler.events();
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0].start_ns, 2u);
+    EXPECT_EQ(events[2].start_ns, 4u);
+}
+
+TEST(Profiler, WritesChromeTraceEvents)
+{
+    Profiler profiler;
+    profiler.set_enabled(true);
+    profiler.record("Track pass (GPU)", 1500, 2500, Profiler::Track::gpu, 3);
+
+    std::ostringstream trace;
+    profiler.write_chrome_trace(trace);
+    EXPECT_NE(trace.str().find(R"json({"name":"Track pass (GPU)","ph":"X","pid":0,"tid":1,)json"
+                               R"json("ts":1.500,"dur":2.500,"args":{"frame":3}})json"),
+              std::string::npos)
+        << trace.str();
+}
+
+TEST(Profiler, WritesLateTimestampsExactly)
+{
+    Profiler profiler;
+    profiler.set_enabled(true);
+    profiler.record("Frame", 12345678901, 16000007, Profiler::Track::cpu, 0);
+
+    std::ostringstream trace;
+    profiler.write_chrome_trace(trace);
+    EXPECT_NE(trace.str().find(R"json("ts":12345678.901,"dur":16000.007,)json"), std::string::npos)
+        << trace.str();
+}
@@ -0,0 +1,25 @@
+#include <gtest/gtest.h>
+
+#include <program_cache.h>
+
+#include <cstdio>
+#include <string>
+
+TEST(ProgramCache, RoundTripsOnlyForTheSameKey)
+{
+    ProgramBinary binary;
+    binary.format = 0x8740;
+    binary.bytes = {'b', 'i', 'n', '\0', 'a', 'r', 'y'};
+    const auto filename = ::testing::TempDir() + "program_cache.programcache";
+    ASSERT_TRUE(write_program_cache(filename.c_str(), 7, binary));
+
+    const auto loaded = read_program_cache(filename.c_str(), 7);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->format, binary.format);
+    EXPECT_EQ(loaded->bytes, binary.bytes);
+
+    EXPECT_FALSE(read_program_cache(filename.c_str(), 8).has_value());
+    const auto missing = ::testing::TempDir() + "missing.programcache";
+    EXPECT_FALSE(read_program_cache(missing.c_str(), 7).has_value());
+    std::remove(filename.c_str());
+}
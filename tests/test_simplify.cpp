@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <simplify.h>
+#include <world_grid.h>
+
+// A flat `cells` x `cells` grid of quads on the ground plane, two triangles each
+static Model flat_grid(uint32_t cells, uint16_t u)
+{
+    Model grid;
+    for (uint32_t z = 0; z <= cells; ++z) {
+        for (uint32_t x = 0; x <= cells; ++x) {
+            grid.vertices.push_back({{static_cast<float>(x), 0, static_cast<float>(z)},
+                                     pack_normal({0, 1.0f, 0}),
+                                     {u, 0}});
+        }
+    }
+    for (uint32_t z = 0; z < cells; ++z) {
+        for (uint32_t x = 0; x < cells; ++x) {
+            const auto corner = z * (cells + 1) + x;
+            grid.indices.insert(grid.indices.end(), {corner, corner + cells + 1, corner + 1});
+            grid.indices.insert(grid.indices.end(),
+                                {corner + 1, corner + cells + 1, corner + cells + 2});
+        }
+    }
+    return grid;
+}
+
+TEST(Simplify, ReachesTheTargetOnAFlatSurface)
+{
+    const auto grid = flat_grid(8, 0);
+    const auto simplified = simplify_model(grid.view(), 16);
+
+    EXPECT_LE(simplified.indices.size() / 3, 16u);
+    EXPECT_GT(simplified.indices.size(), 0u);
+    // Collapses stay on the plane and the open border holds the outline in place
+    const auto before = mesh_bounds(grid.view());
+    const auto after = mesh_bounds(simplified.view());
+    EXPECT_EQ(after.min, before.min);
+    EXPECT_EQ(after.max, before.max);
+}
+
+TEST(Simplify, KeepsEveryCornersAttributes)
+{
+    const auto grid = flat_grid(4, 1234);
+    const auto simplified = simplify_model(grid.view(), 8);
+
+    for (const auto& vertex : simplified.vertices) {
+        EXPECT_EQ(vertex.tex[0], 1234u);
+        EXPECT_EQ(vertex.norm, pack_normal({0, 1.0f, 0}));
+    }
+    for (const auto index : simplified.indices) {
+        EXPECT_LT(index, simplified.vertices.size());
+    }
+}
+
+TEST(Simplify, AddsNamedLevelsOfDetail)
+{
+    std::map<std::string, Model> models{{"Grid", flat_grid(8, 0)}};
+    add_lod_levels(models);
+
+    ASSERT_EQ(models.size(), lod_level_count);
+    size_t previous = models["Grid"].indices.size();
+    for (size_t level = 1; level < lod_level_count; ++level) {
+        const auto& lod = models.at(lod_name("Grid", level));
+        EXPECT_LT(lod.indices.size(), previous);
+        previous = lod.indices.size();
+    }
+}
+
+TEST(Simplify, SelectsCoarserLevelsAsMeshesShrink)
+{
+    EXPECT_EQ(select_lod_level(500.0f, 128.0f), 0u);
+    EXPECT_EQ(select_lod_level(100.0f, 128.0f), 1u);
+    EXPECT_EQ(select_lod_level(50.0f, 128.0f), 2u);
+    EXPECT_EQ(select_lod_level(1.0f, 128.0f), lod_level_count - 1);
+}
+
+TEST(Simplify, HoldsTheLevelNearAThreshold)
+{
+    // Hovering either side of the 128 pixel threshold keeps whichever level it came in at
+    EXPECT_EQ(select_lod_level(120.0f, 0, 128.0f), 0u);
+    EXPECT_EQ(select_lod_level(135.0f, 1, 128.0f), 1u);
+    // Well past it, it switches
+    EXPECT_EQ(select_lod_level(100.0f, 0, 128.0f), 1u);
+    EXPECT_EQ(select_lod_level(161.0f, 1, 128.0f), 0u);
+    // Large jumps cross several levels at once
+    EXPECT_EQ(select_lod_level(1.0f, 0, 128.0f), lod_level_count - 1);
+    EXPECT_EQ(select_lod_level(500.0f, lod_level_count - 1, 128.0f), 0u);
+    // Without a previous level it picks as if there were no margin
+    EXPECT_EQ(select_lod_level(120.0f, lod_level_count, 128.0f), 1u);
+
+    // A size that wobbles around the threshold from frame to frame never pops
+    size_t level = lod_level_count;
+    for (size_t frame = 0; frame < 20; ++frame) {
+        const auto next = select_lod_level(frame % 2 == 0 ? 124.0f : 132.0f, level, 128.0f);
+        if (level < lod_level_count) {
+            EXPECT_EQ(next, level) << "frame " << frame;
+        }
+        level = next;
+    }
+}
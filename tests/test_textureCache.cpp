@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <texture_cache.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(MipChain, HalvesEveryLevelDownToOneTexel)
+{
+    const std::vector<uint8_t> level0(4 * 8 * 2, 255);
+    const auto image = build_mip_chain(8, 2, level0);
+
+    ASSERT_EQ(image.levels.size(), 4u);
+    EXPECT_EQ(image.levels[1].width, 4u);
+    EXPECT_EQ(image.levels[1].height, 1u);
+    EXPECT_EQ(image.levels[3].width, 1u);
+    EXPECT_EQ(image.levels[3].height, 1u);
+    EXPECT_EQ(image.levels[3].offset + image.level_size(3), image.pixels.size());
+}
+
+TEST(MipChain, AveragesEachTwoByTwoBlock)
+{
+    // A 2x2 image of black, white, red and blue texels
+    const std::vector<uint8_t> level0{0,   0, 0, 255, 255, 255, 255, 255,
+                                      255, 0, 0, 255, 0,   0,   255, 255};
+    const auto image = build_mip_chain(2, 2, level0);
+
+    ASSERT_EQ(image.levels.size(), 2u);
+    const auto* texel = &image.pixels[image.levels[1].offset];
+    EXPECT_EQ(texel[0], 128);
+    EXPECT_EQ(texel[1], 64);
+    EXPECT_EQ(texel[2], 128);
+    EXPECT_EQ(texel[3], 255);
+}
+
+TEST(TextureCache, RoundTripsOnlyForTheSameSource)
+{
+    std::vector<uint8_t> level0(4 * 4 * 4);
+    for (size_t i = 0; i < level0.size(); ++i) {
+        level0[i] = static_cast<uint8_t>(i);
+    }
+    const auto image = build_mip_chain(4, 4, level0);
+    const auto filename = ::testing::TempDir() + "texture_cache.texcache";
+    ASSERT_TRUE(write_texture_cache(filename.c_str(), 42, image));
+
+    MipmappedImage loaded;
+    ASSERT_TRUE(read_texture_cache(filename.c_str(), 42, loaded));
+    ASSERT_EQ(loaded.levels.size(), image.levels.size());
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        EXPECT_EQ(loaded.levels[i].width, image.levels[i].width);
+        EXPECT_EQ(loaded.levels[i].height, image.levels[i].height);
+        EXPECT_EQ(loaded.levels[i].offset, image.levels[i].offset);
+    }
+    EXPECT_EQ(loaded.pixels, image.pixels);
+
+    EXPECT_FALSE(read_texture_cache(filename.c_str(), 43, loaded));
+    const auto missing = ::testing::TempDir() + "missing.texcache";
+    EXPECT_FALSE(read_texture_cache(missing.c_str(), 42, loaded));
+    std::remove(filename.c_str());
+}
+
+TEST(TextureCache, RejectsForgedLevels)
+{
+    const auto filename = ::testing::TempDir() + "forged.texcache";
+    ASSERT_TRUE(
+        write_texture_cache(filename.c_str(), 42, build_mip_chain(2, 2, std::vector<uint8_t>(16))));
+    std::ostringstream contents;
+    contents << std::ifstream(filename, std::ios::binary).rdbuf();
+    const auto bytes = contents.str();
+    TextureCacheLevel original;
+    std::memcpy(&original, bytes.data() + sizeof(TextureCacheHeader), sizeof(original));
+
+    const auto forged = [&](const TextureCacheLevel& level) {
+        auto copy = bytes;
+        std::memcpy(copy.data() + sizeof(TextureCacheHeader), &level, sizeof(level));
+        std::ofstream(filename, std::ios::binary | std::ios::trunc) << copy;
+        MipmappedImage loaded;
+        return read_texture_cache(filename.c_str(), 42, loaded);
+    };
+    EXPECT_TRUE(forged(original));
+
+    // Sizes beyond any texture
+    auto level = original;
+    level.width = UINT32_MAX;
+    level.height = UINT32_MAX;
+    EXPECT_FALSE(forged(level));
+    // An offset so large that adding the size wraps back into the file
+    level = original;
+    level.offset = UINT64_MAX - 8;
+    EXPECT_FALSE(forged(level));
+    // Past the end of the file
+    level = original;
+    level.offset = bytes.size() + 1;
+    EXPECT_FALSE(forged(level));
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <thread_pool.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+TEST(ThreadPool, ParallelRangesCoverEveryIndexOnce)
+{
+    ThreadPool pool(4);
+    for (const size_t count : {0u, 1u, 7u, 16u, 17u, 1000u}) {
+        std::vector<std::atomic<int>> visits(count);
+        pool.parallel_for_ranges(count, 16, [&](size_t begin, size_t end) {
+            EXPECT_LT(begin, end);
+            EXPECT_LE(end - begin, 16u);
+            for (size_t i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(visits[i], 1) << "index " << i << " of " << count;
+        }
+    }
+}
+
+TEST(ThreadPool, ParallelRangesNestInsideJobs)
+{
+    ThreadPool pool(2);
+    std::atomic<size_t> total{0};
+    pool.parallel_for(4, [&](size_t) {
+        pool.parallel_for_ranges(100, 8, [&](size_t begin, size_t end) { total += end - begin; });
+    });
+    EXPECT_EQ(total, 400u);
+}
+
+TEST(ThreadPool, ParallelForLeavesOtherJobsToTheWorkers)
+{
+    ThreadPool pool(1);
+    std::promise<void> started;
+    std::promise<void> release;
+    auto blocker = pool.submit([&] {
+        started.set_value();
+        release.get_future().wait();
+    });
+    started.get_future().wait();
+    // Queued behind the blocked worker, where a waiting caller could have picked it up
+    auto queued = pool.submit([] { return std::this_thread::get_id(); });
+
+    std::atomic<size_t> total{0};
+    pool.parallel_for(4, [&](size_t i) { total += i; });
+    EXPECT_EQ(total, 6u);
+
+    release.set_value();
+    blocker.get();
+    EXPECT_NE(queued.get(), std::this_thread::get_id());
+}
@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+
+#include <track.h>
+#include <track_field.h>
+#include <track_query.h>
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+static_assert(segment_type_from_ascii('|') == SegmentType::vertical);
+static_assert(segment_type_from_ascii('x') == SegmentType::grass);
+
+TEST(Track, ResolvesTilesOnceAtLoad)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    ASSERT_EQ(track.rows(), 4u);
+    ASSERT_EQ(track.columns(), 5u);
+
+    const auto& start = track.at(3, 2);
+    EXPECT_EQ(start.type, SegmentType::starting_line);
+    EXPECT_EQ(start.centre, glm::vec2(120.0f, 180.0f));
+    EXPECT_EQ(start.pivot, start.centre);
+
+    const auto& corner = track.at(0, 3);
+    EXPECT_EQ(corner.type, SegmentType::top_left);
+    EXPECT_EQ(corner.pivot, corner.centre + glm::vec2(30.0f, 30.0f));
+    EXPECT_EQ(track.at(0, 0).type, SegmentType::grass);
+}
+
+TEST(Track, FollowsTheCornersAroundTheLoop)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    const auto order = segment_order(track);
+    ASSERT_EQ(order.size(), 16u);
+    EXPECT_EQ(order[0], std::make_pair(size_t{3}, size_t{2}));
+    // Leaving the start line to the left, along the bottom row to the corner
+    EXPECT_EQ(order[1], std::make_pair(size_t{3}, size_t{1}));
+    EXPECT_EQ(order[2], std::make_pair(size_t{3}, size_t{0}));
+    EXPECT_EQ(order[3], std::make_pair(size_t{2}, size_t{0}));
+    // Each tile neighbours the next
+    for (size_t i = 0; i < order.size(); ++i) {
+        const auto& a = order[i];
+        const auto& b = order[(i + 1) % order.size()];
+        const auto rows = a.first > b.first ? a.first - b.first : b.first - a.first;
+        const auto columns = a.second > b.second ? a.second - b.second : b.second - a.second;
+        EXPECT_EQ(rows + columns, 1u);
+    }
+}
+
+TEST(TrackDistanceField, ChecksTheEdgesOfStraightsAndCurves)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    // Samples 3 units apart, fine enough to follow the curves to a few hundredths
+    const TrackDistanceField field(track, 20);
+    // The starting line runs along x, so only z is bounded
+    EXPECT_NEAR(field.distance({120.0f, 180.0f}), -9.0f, 1e-4f);
+    EXPECT_TRUE(field.is_on_track({120.0f, 180.0f + 8.5f}));
+    EXPECT_FALSE(field.is_on_track({120.0f, 180.0f + 9.5f}));
+    EXPECT_TRUE(field.is_on_track({120.0f, 180.0f + 10.5f}, 2.0f));
+    // The top left corner's arc has a radius of 30 about the tile's far corner
+    const glm::vec2 pivot{210.0f, 30.0f};
+    EXPECT_NEAR(field.distance(pivot - glm::vec2(21.0f, 21.0f)), 30.0f - 29.698f - 9.0f, 0.05f);
+    EXPECT_NEAR(field.distance(pivot - glm::vec2(0.0f, 40.0f)), 1.0f, 0.05f);
+    EXPECT_FALSE(field.is_on_track({181.0f, 1.0f}));
+    // Grass and anywhere off the layout are never track
+    EXPECT_FALSE(field.is_on_track({0.0f, 0.0f}));
+    EXPECT_FALSE(field.is_on_track({-100.0f, 180.0f}));
+    EXPECT_GT(field.distance({120.0f, 1000.0f}), 700.0f);
+}
+
+TEST(TrackDistanceField, IsContinuousWhereTilesMeet)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    const TrackDistanceField field(track, 20);
+    // A distance changes no faster than the point moves, across tile borders included
+    constexpr float step = 0.25f;
+    for (float z = -30.0f; z < 210.0f; z += 7.0f) {
+        for (float x = -30.0f; x < 270.0f; x += step) {
+            EXPECT_LE(std::abs(field.distance({x + step, z}) - field.distance({x, z})),
+                      step + 1e-3f)
+                << x << ", " << z;
+        }
+    }
+    // Where the bottom right corner meets the straights either side, the edge runs on unbroken
+    EXPECT_NEAR(field.distance({240.0f + 9.0f, 150.0f}), 0.0f, 0.05f);
+    EXPECT_NEAR(field.distance({210.0f, 180.0f + 9.0f}), 0.0f, 0.05f);
+    const glm::vec2 corner_pivot{210.0f, 150.0f};
+    EXPECT_NEAR(field.distance(corner_pivot + glm::vec2(std::cos(0.7f), std::sin(0.7f)) * 39.0f),
+                0.0f, 0.05f);
+}
+
+TEST(TrackDistanceField, KeepsEdgesCloseAtTheDefaultSpacing)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    const TrackDistanceField field(track);
+    // Straights are exact at any spacing, and curves bend a little between samples
+    EXPECT_NEAR(field.distance({120.0f, 180.0f + 9.0f}), 0.0f, 1e-4f);
+    const glm::vec2 corner_pivot{210.0f, 150.0f};
+    for (float angle = 0.0f; angle <= 1.5f; angle += 0.1f) {
+        const glm::vec2 out{std::cos(angle), std::sin(angle)};
+        EXPECT_NEAR(field.distance(corner_pivot + out * 39.0f), 0.0f, 0.3f) << angle;
+        EXPECT_NEAR(field.distance(corner_pivot + out * 21.0f), 0.0f, 0.3f) << angle;
+    }
+}
+
+TEST(TrackDistanceField, ClampsBackOntoTheTrack)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    const TrackDistanceField field(track);
+    glm::vec2 position{120.0f, 200.0f};
+    field.clamp(position);
+    EXPECT_NEAR(position.x, 120.0f, 1e-4f);
+    EXPECT_NEAR(position.y, 189.0f, 1e-4f);
+
+    const glm::vec2 pivot{210.0f, 30.0f};
+    position = pivot - glm::vec2(50.0f, 0.0f);
+    field.clamp(position);
+    EXPECT_NEAR(glm::length(position - pivot), 39.0f, 0.05f);
+
+    // Off the end of a straight and onto the grass, it comes back to the nearest track
+    position = {120.0f, 90.0f + 25.0f};
+    field.clamp(position);
+    EXPECT_LE(field.distance(position), 0.05f);
+}
+
+// A big layout of every segment type, not necessarily joined up, to exercise every tile kind
+static std::string scrambled_layout(size_t rows, size_t columns)
+{
+    const char tiles[] = " s-|r;jl";
+    std::string text;
+    uint32_t state = 12345;
+    for (size_t row = 0; row < rows; ++row) {
+        for (size_t column = 0; column < columns; ++column) {
+            state = state * 1664525u + 1013904223u;
+            text += tiles[(state >> 16) % 8];
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+TEST(TrackQuery, EveryPathAgreesWithTheField)
+{
+    const auto track = translate_track_layout(scrambled_layout(20, 30).c_str());
+    const TrackDistanceField field(track);
+    const TrackQuery query(field);
+
+    // Points spread a little past every edge of the layout, with an odd count to leave a tail
+    std::vector<float> xs;
+    std::vector<float> ys;
+    uint32_t state = 1;
+    const auto next = [&] {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+    };
+    for (size_t i = 0; i < 20003; ++i) {
+        xs.push_back(next() * 31.0f * 60.0f - 60.0f);
+        ys.push_back(next() * 21.0f * 60.0f - 60.0f);
+    }
+
+    std::vector<TrackQuery::Path> paths{TrackQuery::Path::scalar};
+#if defined(RC_TRACK_QUERY_SSE2)
+    paths.push_back(TrackQuery::Path::sse2);
+#endif
+    if (TrackQuery::best_path() == TrackQuery::Path::avx2) {
+        paths.push_back(TrackQuery::Path::avx2);
+    }
+
+    size_t on_track_count = 0;
+    for (const auto path : paths) {
+        std::vector<uint8_t> on_track(xs.size(), 2);
+        query.on_track_with(path, xs.data(), ys.data(), xs.size(), 2.0f, on_track.data());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            const uint8_t expected = field.is_on_track({xs[i], ys[i]}, 2.0f) ? 1 : 0;
+            ASSERT_EQ(on_track[i], expected) << "point " << i << " on path "
+                                             << static_cast<int>(path);
+            on_track_count += expected;
+        }
+    }
+    // Both answers turn up plenty
+    EXPECT_GT(on_track_count, xs.size() * paths.size() / 10);
+    EXPECT_LT(on_track_count, xs.size() * paths.size() / 2);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <truck_sim.h>
+
+#include <cstring>
+
+static const char* test_layout = "r-;\n"
+                                 "l-s\n";
+
+static TruckState drive(const TrackDistanceField& track, size_t ticks)
+{
+    TruckState truck;
+    truck.position = {120.0f, 60.0f};
+    truck.angle = 1.5f;
+    for (size_t tick = 0; tick < ticks; ++tick) {
+        InputState input;
+        input.accel = tick < 300;
+        input.left = tick % 90 < 30;
+        step_truck(truck, input, track);
+    }
+    return truck;
+}
+
+TEST(TruckSim, SameInputReproducesTheSameBits)
+{
+    const TrackDistanceField track(translate_track_layout(test_layout));
+    const auto a = drive(track, 600);
+    const auto b = drive(track, 600);
+    EXPECT_EQ(std::memcmp(&a, &b, sizeof(TruckState)), 0);
+}
+
+TEST(TruckSim, StaysBetweenTheEdgesOfAStraight)
+{
+    const TrackDistanceField track(translate_track_layout(test_layout));
+    TruckState truck;
+    truck.position = {120.0f, 60.0f};
+    // Facing straight across the Starting_Line tile, towards its edge
+    truck.angle = 0;
+    InputState input;
+    input.accel = true;
+    for (size_t tick = 0; tick < 240; ++tick) {
+        step_truck(truck, input, track);
+        // Clamping goes through the sampled distance field, so allow for its rounding
+        EXPECT_GE(truck.position.y, 60.0f - 9.0f - 1e-3f);
+        EXPECT_LE(truck.position.y, 60.0f + 9.0f + 1e-3f);
+    }
+}
+
+TEST(FixedTimestep, CarriesLeftoverTimeToTheNextFrame)
+{
+    FixedTimestep timestep(0.01);
+    EXPECT_EQ(timestep.advance(0.025), 2u);
+    EXPECT_NEAR(timestep.alpha(), 0.5f, 1e-4f);
+    EXPECT_EQ(timestep.advance(0.005), 1u);
+    EXPECT_NEAR(timestep.alpha(), 0.0f, 1e-4f);
+}
+
+TEST(FixedTimestep, DropsTimeAfterALongStall)
+{
+    FixedTimestep timestep(0.01, 4);
+    EXPECT_EQ(timestep.advance(10.0), 4u);
+    EXPECT_EQ(timestep.advance(0.0), 0u);
+}
+
+TEST(TruckSim, InterpolatesBetweenTicks)
+{
+    TruckState previous;
+    TruckState current;
+    current.position = {2.0f, 4.0f};
+    current.angle = 1.0f;
+    const auto halfway = interpolate(previous, current, 0.5f);
+    EXPECT_FLOAT_EQ(halfway.position.x, 1.0f);
+    EXPECT_FLOAT_EQ(halfway.position.y, 2.0f);
+    EXPECT_FLOAT_EQ(halfway.angle, 0.5f);
+}
+
+TEST(RaceProgress, CountsLapsOnlyInTrackOrder)
+{
+    const auto track = translate_track_layout(default_track_layout);
+    const auto order = segment_order(track);
+    RaceProgress progress;
+
+    // Skipping ahead a segment does not count
+    EXPECT_FALSE(progress.update(order[2], order));
+    for (size_t lap = 0; lap < 2; ++lap) {
+        for (size_t i = 1; i <= order.size(); ++i) {
+            EXPECT_TRUE(progress.update(order[i % order.size()], order));
+            // Staying on a segment does not count twice
+            EXPECT_FALSE(progress.update(order[i % order.size()], order));
+        }
+    }
+    EXPECT_EQ(progress.segments_reached, 2 * order.size());
+    EXPECT_EQ(progress.laps_completed(order.size()), 1u);
+    EXPECT_TRUE(progress.update(order[1], order));
+    EXPECT_EQ(progress.laps_completed(order.size()), 2u);
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <vehicle_store.h>
+
+#include <cstring>
+#include <vector>
+
+static const char* test_layout = "r-;\n"
+                                 "l-s\n";
+
+TEST(VehicleStore, StepsEachTruckAsStepTruckWould)
+{
+    const TrackDistanceField track(translate_track_layout(test_layout));
+    ThreadPool pool(4);
+
+    // Enough trucks to spread over several ranges, each with its own handling and input
+    VehicleStore vehicles;
+    std::vector<TruckState> expected;
+    std::vector<TruckParameters> parameters;
+    for (size_t i = 0; i < 70; ++i) {
+        TruckState state;
+        state.position = {100.0f + static_cast<float>(i % 10), 60.0f};
+        state.angle = 1.5f;
+        TruckParameters handling;
+        handling.max_power = 100.0f + static_cast<float>(i);
+        EXPECT_EQ(vehicles.add(state, handling), i);
+        expected.push_back(state);
+        parameters.push_back(handling);
+    }
+    const auto input_for = [](size_t vehicle, size_t tick) {
+        InputState input;
+        input.accel = tick < 200 + vehicle;
+        input.left = (tick + vehicle) % 90 < 30;
+        return input;
+    };
+
+    for (size_t tick = 0; tick < 300; ++tick) {
+        vehicles.step(track, pool, [&](size_t vehicle, const TruckState&) {
+            return input_for(vehicle, tick);
+        });
+        for (size_t i = 0; i < expected.size(); ++i) {
+            step_truck(expected[i], input_for(i, tick), track, parameters[i]);
+        }
+    }
+    ASSERT_EQ(vehicles.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const auto state = vehicles.state(i);
+        EXPECT_EQ(std::memcmp(&state, &expected[i], sizeof(TruckState)), 0) << "truck " << i;
+        EXPECT_EQ(vehicles.parameters(i).max_power, parameters[i].max_power);
+    }
+}
+
+TEST(VehicleStore, InterpolatesFromThePreviousTick)
+{
+    const TrackDistanceField track(translate_track_layout(test_layout));
+    VehicleStore vehicles;
+    TruckState start;
+    start.position = {120.0f, 60.0f};
+    vehicles.add(start);
+    vehicles.step(track, ThreadPool::shared(), [](size_t, const TruckState&) {
+        return InputState{false, false, true, false};
+    });
+
+    const auto after = vehicles.state(0);
+    EXPECT_NE(after.position, start.position);
+    EXPECT_EQ(vehicles.interpolated(0, 0.0f).position, start.position);
+    const auto halfway = vehicles.interpolated(0, 0.5f);
+    EXPECT_FLOAT_EQ(halfway.position.y, (start.position.y + after.position.y) * 0.5f);
+}
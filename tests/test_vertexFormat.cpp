@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <model.h>
+
+TEST(VertexFormat, NormalsSurvivePacking)
+{
+    for (const auto& normal : {glm::vec3{0, 1.0f, 0}, glm::vec3{-1.0f, 0, 0},
+                               glm::normalize(glm::vec3{1.0f, -2.0f, 3.0f})}) {
+        const auto unpacked = unpack_normal(pack_normal(normal));
+        EXPECT_NEAR(unpacked.x, normal.x, 1.0f / 511.0f);
+        EXPECT_NEAR(unpacked.y, normal.y, 1.0f / 511.0f);
+        EXPECT_NEAR(unpacked.z, normal.z, 1.0f / 511.0f);
+    }
+}
+
+TEST(VertexFormat, NormalFieldsMatchGlLayout)
+{
+    // GL_INT_2_10_10_10_REV keeps x in the lowest 10 bits and leaves the top 2 for w
+    EXPECT_EQ(pack_normal({1.0f, 0, 0}), 511u);
+    EXPECT_EQ(pack_normal({0, -1.0f, 0}), 0x201u << 10);
+    EXPECT_EQ(pack_normal({0, 0, 1.0f}) >> 30, 0u);
+}
+
+TEST(VertexFormat, TextureCoordinatesAreClampedUnorm)
+{
+    EXPECT_EQ(pack_unorm16(0), 0u);
+    EXPECT_EQ(pack_unorm16(1.0f), 65535u);
+    EXPECT_EQ(pack_unorm16(1.5f), 65535u);
+    EXPECT_NEAR(unpack_unorm16(pack_unorm16(0.3f)), 0.3f, 1.0f / 65535.0f);
+}
+
+TEST(VertexFormat, ModelsArePackedFromObjData)
+{
+    ObjFile obj;
+    obj.process_text(R"(o Triangle
+                        v 0.0 0.0 0.0
+                        v 1.0 0.0 0.0
+                        v 0.0 1.0 0.0
+                        vt 0.25 0.0
+                        vn 0.0 0.0 1.0
+                        f 1/1/1 2/1/1 3/1/1)");
+    const auto model = model_from_mesh(obj.produce_indexed_mesh("Triangle"));
+
+    ASSERT_EQ(model.vertices.size(), 3u);
+    const auto& vertex = model.vertices[1];
+    EXPECT_EQ(vertex.pos, glm::vec3(1.0f, 0, 0));
+    EXPECT_EQ(vertex.norm, pack_normal({0, 0, 1.0f}));
+    EXPECT_EQ(vertex.tex[0], pack_unorm16(0.25f));
+    EXPECT_EQ(vertex.tex[1], 65535u); // v is flipped for GL
+}
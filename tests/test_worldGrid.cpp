@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <world_grid.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static Aabb box_at(float x, float z, float half_size = 1.0f)
+{
+    return {{x - half_size, 0, z - half_size}, {x + half_size, 2.0f, z + half_size}};
+}
+
+TEST(WorldGrid, ChunksFollowTheTileGrid)
+{
+    // 5 x 4 tiles in chunks of 2 x 2 tiles: 3 chunk columns and 2 chunk rows
+    const WorldGrid grid(4, 5, 2);
+    EXPECT_EQ(grid.chunk_count(), 6u);
+
+    // Tile (0, 0) is centred on the origin and reaches 30 units either way
+    EXPECT_EQ(grid.chunk_at({0, 0}), 0u);
+    EXPECT_EQ(grid.chunk_at({89.0f, 89.0f}), 0u);
+    EXPECT_EQ(grid.chunk_at({91.0f, 0}), 1u);
+    EXPECT_EQ(grid.chunk_at({240.0f, 180.0f}), 5u);
+
+    // Anything off the edge of the layout belongs to the nearest chunk
+    EXPECT_EQ(grid.chunk_at({-100.0f, -100.0f}), 0u);
+    EXPECT_EQ(grid.chunk_at({1000.0f, 1000.0f}), 5u);
+}
+
+TEST(WorldGrid, OnlyReportsVisibleChunksWithContent)
+{
+    WorldGrid grid(4, 4, 1);
+    grid.include(grid.chunk_at({0, 0}), box_at(0, 0));
+    grid.include(grid.chunk_at({180.0f, 180.0f}), box_at(180.0f, 180.0f));
+
+    // Looking straight down at tile (0, 0) from close by
+    const auto view = glm::lookAt(glm::vec3{0, 50.0f, 0}, glm::vec3{0}, glm::vec3{0, 0, -1.0f});
+    const auto projection = glm::perspective(glm::radians(35.0f), 1.0f, 0.1f, 100.0f);
+
+    std::vector<size_t> visible;
+    grid.visible_chunks(Frustum(projection * view), visible);
+    EXPECT_EQ(visible, std::vector<size_t>{grid.chunk_at({0, 0})});
+}
+
+TEST(Frustum, CullsBoxesOutsideEachPlane)
+{
+    const auto view = glm::lookAt(glm::vec3{0, 0, 10.0f}, glm::vec3{0}, glm::vec3{0, 1.0f, 0});
+    const Frustum frustum(glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 50.0f) * view);
+
+    EXPECT_TRUE(frustum.intersects(box_at(0, 0)));
+    EXPECT_FALSE(frustum.intersects(box_at(100.0f, 0)));
+    EXPECT_FALSE(frustum.intersects(box_at(-100.0f, 0)));
+    EXPECT_FALSE(frustum.intersects(box_at(0, 20.0f)));  // behind the camera
+    EXPECT_FALSE(frustum.intersects(box_at(0, -60.0f))); // beyond the far plane
+
+    // A box straddling a plane still counts as visible
+    EXPECT_TRUE(frustum.intersects(box_at(10.0f, 0, 2.0f)));
+}
+
+TEST(Aabb, PlacedBoundsHoldTheMeshAtAnyAngle)
+{
+    const Aabb local{{-1.0f, 0, -2.0f}, {1.0f, 3.0f, 2.0f}};
+    const auto placed = placed_bounds(local, {10.0f, 20.0f}, 2.0f);
+
+    const auto radius = std::sqrt(5.0f) * 2.0f;
+    EXPECT_FLOAT_EQ(placed.min.x, 10.0f - radius);
+    EXPECT_FLOAT_EQ(placed.max.z, 20.0f + radius);
+    EXPECT_FLOAT_EQ(placed.max.y, 6.0f);
+    EXPECT_TRUE(placed_bounds(Aabb{}, {0, 0}, 1.0f).empty());
+}